@@ -0,0 +1,47 @@
+# PlatformIO post-build script: prints how the firmware uses the Teensy 4.1
+# memory regions, so growing pixel counts or buffers doesn't silently eat
+# the stack or push hot data out of DTCM.
+#
+# RAM1 (512K) holds ITCM code, allocated in 32K blocks, followed by DTCM
+# data/bss and the stack. RAM2 (512K OCRAM) holds DMAMEM and the heap.
+
+Import("env")
+
+import subprocess
+
+RAM1_SIZE = 512 * 1024
+RAM2_SIZE = 512 * 1024
+FLASH_SIZE = 8126464 # 8MB less the reserved EEPROM emulation and restore areas
+ITCM_BLOCK = 32 * 1024
+
+
+def section_sizes(elf):
+    output = subprocess.check_output([env.subst("$SIZETOOL"), "-A", elf]).decode()
+    sizes = {}
+    for line in output.splitlines():
+        fields = line.split()
+        if len(fields) >= 2 and fields[0].startswith(".") and fields[1].isdigit():
+            sizes[fields[0]] = int(fields[1])
+    return sizes
+
+
+def memory_report(source, target, env):
+    sizes = section_sizes(str(target[0]))
+    get = lambda name: sizes.get(name, 0)
+
+    itcm = get(".text.itcm") + get(".ARM.exidx")
+    itcm_blocks = (itcm + ITCM_BLOCK - 1) // ITCM_BLOCK * ITCM_BLOCK
+    dtcm = get(".data") + get(".bss")
+    ocram = get(".bss.dma")
+    flash = get(".text.headers") + get(".text.code") + get(".text.progmem") + itcm + get(".data")
+
+    print("")
+    print("Memory usage (Teensy 4.1)")
+    print("  FLASH: %7d bytes code/data, %7d free" % (flash, FLASH_SIZE - flash))
+    print("  RAM1:  %7d bytes ITCM code (%d padded), %d bytes DTCM data/bss" % (itcm, itcm_blocks, dtcm))
+    print("         %7d bytes free for the stack" % (RAM1_SIZE - itcm_blocks - dtcm))
+    print("  RAM2:  %7d bytes DMAMEM, %7d free for the heap" % (ocram, RAM2_SIZE - ocram))
+    print("")
+
+
+env.AddPostAction("$BUILD_DIR/${PROGNAME}.elf", memory_report)
@@ -2,9 +2,21 @@
 
 #include "artnet.h"
 
-Artnet::Artnet() {}
+const Artnet::opcode_handler_s Artnet::handlers[] = {
+  { ART_DMX,  &Artnet::handleDmx },
+  { ART_POLL, &Artnet::handlePoll },
+  { ART_SYNC, &Artnet::handleSync },
+};
 
-void Artnet::begin(byte mac[], byte ip[])
+Artnet::Artnet() : routeCount(0), outputCount(0), forwarded(0)
+{
+  // Every handled opcode has a zero low byte, index the handlers by the high byte
+  memset(dispatch, 0, sizeof(dispatch));
+  for (uint8_t i = 0; i < sizeof(handlers) / sizeof(handlers[0]); i++)
+    dispatch[handlers[i].opcode >> 8] = i + 1;
+}
+
+FLASHMEM void Artnet::begin(byte mac[], byte ip[])
 {
   #if !defined(ARDUINO_SAMD_ZERO) && !defined(ESP8266) && !defined(ESP32)
     Ethernet.begin(mac,ip);
@@ -46,120 +58,268 @@ void Artnet::setBroadcast(IPAddress bc)
 uint16_t Artnet::read()
 {
   packetSize = Udp.parsePacket();
+  if (packetSize < ART_HEADER_SIZE || packetSize > MAX_BUFFER_ARTNET)
+    return 0;
 
+  // Check ID and protocol version before copying the rest, the ID as a
+  // single 8-byte word
+  Udp.read(artnetPacket, ART_HEADER_SIZE);
+  uint64_t packetId;
+  memcpy(&packetId, artnetPacket, sizeof(packetId));
+  if (packetId != ART_NET_ID_WORD)
+    return 0;
+  if ((artnetPacket[10] << 8 | artnetPacket[11]) < ART_NET_VERSION)
+    return 0;
+  Udp.read(artnetPacket + ART_HEADER_SIZE, packetSize - ART_HEADER_SIZE);
   remoteIP = Udp.remoteIP();
-  if (packetSize <= MAX_BUFFER_ARTNET && packetSize > 0)
+
+  opcode = artnetPacket[8] | artnetPacket[9] << 8;
+  uint8_t handler = (opcode & 0xFF) ? 0 : dispatch[opcode >> 8];
+  if (handler == 0)
+    return 0;
+  return (this->*handlers[handler - 1].handler)();
+}
+
+uint16_t Artnet::handleDmx()
+{
+  if (packetSize < ART_DMX_START)
+    return 0;
+
+  sequence = artnetPacket[12];
+  incomingUniverse = artnetPacket[14] | artnetPacket[15] << 8;
+  dmxDataLength = artnetPacket[17] | artnetPacket[16] << 8;
+
+  // Never hand the callback more data than was actually received
+  if (dmxDataLength > ART_DMX_MAX_LENGTH || ART_DMX_START + dmxDataLength > packetSize)
+    return 0;
+
+  if (artDmxCallback) (*artDmxCallback)(incomingUniverse, dmxDataLength, sequence, artnetPacket + ART_DMX_START, remoteIP);
+  return ART_DMX;
+}
+
+uint16_t Artnet::handlePoll()
+{
+  //fill the reply struct, and then send it to the network's broadcast address
+  Serial.print("POLL from ");
+  Serial.print(remoteIP);
+  Serial.print(" broadcast addr: ");
+  Serial.println(broadcast);
+
+  #if !defined(ARDUINO_SAMD_ZERO) && !defined(ESP8266) && !defined(ESP32)
+    IPAddress local_ip = Ethernet.localIP();
+  #else
+    IPAddress local_ip = WiFi.localIP();
+  #endif
+  node_ip_address[0] = local_ip[0];
+  node_ip_address[1] = local_ip[1];
+  node_ip_address[2] = local_ip[2];
+  node_ip_address[3] = local_ip[3];
+
+  sprintf((char *)id, "Art-Net");
+  memcpy(ArtPollReply.id, id, sizeof(ArtPollReply.id));
+  memcpy(ArtPollReply.ip, node_ip_address, sizeof(ArtPollReply.ip));
+
+  ArtPollReply.opCode = ART_POLL_REPLY;
+  ArtPollReply.port =  ART_NET_PORT;
+
+  memset(ArtPollReply.goodinput,  0x08, 4);
+  memset(ArtPollReply.goodoutput,  0x80, NUMBER_OF_OUTPUTS+1);
+  memset(ArtPollReply.porttypes,  0xc0, 4);
+
+  uint8_t shortname [18];
+  uint8_t longname [64];
+  sprintf((char *)shortname, "Light Node");
+  sprintf((char *)longname, "Desorb Light Node");
+  memcpy(ArtPollReply.shortname, shortname, sizeof(shortname));
+  memcpy(ArtPollReply.longname, longname, sizeof(longname));
+
+  ArtPollReply.etsaman[0] = 0;
+  ArtPollReply.etsaman[1] = 0;
+  ArtPollReply.verH       = 1;
+  ArtPollReply.ver        = 0;
+  ArtPollReply.subH       = 0;
+  ArtPollReply.sub        = 0;
+  ArtPollReply.oemH       = 0;
+  ArtPollReply.oem        = 0xFF;
+  ArtPollReply.ubea       = 0;
+  ArtPollReply.status     = 0xd2;
+  ArtPollReply.swvideo    = 0;
+  ArtPollReply.swmacro    = 0;
+  ArtPollReply.swremote   = 0;
+  ArtPollReply.style      = 0;
+
+  ArtPollReply.numbportsH = 0;
+  ArtPollReply.numbports  = NUMBER_OF_OUTPUTS+1;
+  ArtPollReply.status2    = 0x08;
+
+  ArtPollReply.bindip[0] = node_ip_address[0];
+  ArtPollReply.bindip[1] = node_ip_address[1];
+  ArtPollReply.bindip[2] = node_ip_address[2];
+  ArtPollReply.bindip[3] = node_ip_address[3];
+
+  uint8_t swin[NUMBER_OF_OUTPUTS]  = {0x01,0x02,0x03,0x04,0x05,0x06,0x07,0x08,0x09,0x0A};
+  uint8_t swout[NUMBER_OF_OUTPUTS] = {0x01,0x02,0x03,0x04,0x05,0x06,0x07,0x08,0x09,0x0A};
+  for(uint8_t i = 0; i < NUMBER_OF_OUTPUTS; i++)
   {
-      Udp.read(artnetPacket, MAX_BUFFER_ARTNET);
+      ArtPollReply.swout[i] = swout[i];
+      ArtPollReply.swin[i] = swin[i];
+  }
+  sprintf((char *)ArtPollReply.nodereport, "%i DMX output universes active.", NUMBER_OF_OUTPUTS);
+  Udp.beginPacket(remoteIP, ART_NET_PORT);//send the packet to the specific address
+  Udp.write((uint8_t *)&ArtPollReply, sizeof(ArtPollReply));
+  Udp.endPacket();
 
-      // Check that packetID is "Art-Net" else ignore
-      for (byte i = 0 ; i < 8 ; i++)
-      {
-        if (artnetPacket[i] != ART_NET_ID[i])
-          return 0;
-      }
+  Serial.println(sizeof(ArtPollReply));
 
-      opcode = artnetPacket[8] | artnetPacket[9] << 8;
+  return ART_POLL;
+}
 
-      if (opcode == ART_DMX)
-      {
-        sequence = artnetPacket[12];
-        incomingUniverse = artnetPacket[14] | artnetPacket[15] << 8;
-        dmxDataLength = artnetPacket[17] | artnetPacket[16] << 8;
+uint16_t Artnet::handleSync()
+{
+  if (artSyncCallback) (*artSyncCallback)(remoteIP);
+  return ART_SYNC;
+}
 
-        if (artDmxCallback) (*artDmxCallback)(incomingUniverse, dmxDataLength, sequence, artnetPacket + ART_DMX_START, remoteIP);
-        return ART_DMX;
-      }
-      if (opcode == ART_POLL)
-      {
-        //fill the reply struct, and then send it to the network's broadcast address
-        Serial.print("POLL from ");
-        Serial.print(remoteIP);
-        Serial.print(" broadcast addr: ");
-        Serial.println(broadcast);
-
-        #if !defined(ARDUINO_SAMD_ZERO) && !defined(ESP8266) && !defined(ESP32)
-          IPAddress local_ip = Ethernet.localIP();
-        #else
-          IPAddress local_ip = WiFi.localIP();
-        #endif
-        node_ip_address[0] = local_ip[0];
-      	node_ip_address[1] = local_ip[1];
-      	node_ip_address[2] = local_ip[2];
-      	node_ip_address[3] = local_ip[3];
-
-        sprintf((char *)id, "Art-Net");
-        memcpy(ArtPollReply.id, id, sizeof(ArtPollReply.id));
-        memcpy(ArtPollReply.ip, node_ip_address, sizeof(ArtPollReply.ip));
-
-        ArtPollReply.opCode = ART_POLL_REPLY;
-        ArtPollReply.port =  ART_NET_PORT;
-
-        memset(ArtPollReply.goodinput,  0x08, 4);
-        memset(ArtPollReply.goodoutput,  0x80, NUMBER_OF_OUTPUTS+1);
-        memset(ArtPollReply.porttypes,  0xc0, 4);
-
-        uint8_t shortname [18];
-        uint8_t longname [64];
-        sprintf((char *)shortname, "Light Node");
-        sprintf((char *)longname, "Desorb Light Node");
-        memcpy(ArtPollReply.shortname, shortname, sizeof(shortname));
-        memcpy(ArtPollReply.longname, longname, sizeof(longname));
-
-        ArtPollReply.etsaman[0] = 0;
-        ArtPollReply.etsaman[1] = 0;
-        ArtPollReply.verH       = 1;
-        ArtPollReply.ver        = 0;
-        ArtPollReply.subH       = 0;
-        ArtPollReply.sub        = 0;
-        ArtPollReply.oemH       = 0;
-        ArtPollReply.oem        = 0xFF;
-        ArtPollReply.ubea       = 0;
-        ArtPollReply.status     = 0xd2;
-        ArtPollReply.swvideo    = 0;
-        ArtPollReply.swmacro    = 0;
-        ArtPollReply.swremote   = 0;
-        ArtPollReply.style      = 0;
-
-        ArtPollReply.numbportsH = 0;
-        ArtPollReply.numbports  = NUMBER_OF_OUTPUTS+1;
-        ArtPollReply.status2    = 0x08;
-
-        ArtPollReply.bindip[0] = node_ip_address[0];
-        ArtPollReply.bindip[1] = node_ip_address[1];
-        ArtPollReply.bindip[2] = node_ip_address[2];
-        ArtPollReply.bindip[3] = node_ip_address[3];
-
-        uint8_t swin[NUMBER_OF_OUTPUTS]  = {0x01,0x02,0x03,0x04,0x05,0x06,0x07,0x08,0x09,0x0A};
-        uint8_t swout[NUMBER_OF_OUTPUTS] = {0x01,0x02,0x03,0x04,0x05,0x06,0x07,0x08,0x09,0x0A};
-        for(uint8_t i = 0; i < NUMBER_OF_OUTPUTS; i++)
-        {
-            ArtPollReply.swout[i] = swout[i];
-            ArtPollReply.swin[i] = swin[i];
-        }
-        sprintf((char *)ArtPollReply.nodereport, "%i DMX output universes active.", NUMBER_OF_OUTPUTS);
-        Udp.beginPacket(remoteIP, ART_NET_PORT);//send the packet to the specific address
-        Udp.write((uint8_t *)&ArtPollReply, sizeof(ArtPollReply));
-        Udp.endPacket();
-
-        Serial.println(sizeof(ArtPollReply));
-
-        return ART_POLL;
-      }
-      if (opcode == ART_SYNC)
+void Artnet::send(IPAddress ip, const uint8_t *data, uint16_t length)
+{
+  Udp.beginPacket(ip, ART_NET_PORT);
+  Udp.write(data, length);
+  Udp.endPacket();
+}
+
+// Forward `universe` to `outUniverse` on `target`. Several routes may share
+// an output, their data is merged highest-takes-precedence.
+FLASHMEM bool Artnet::addRoute(uint16_t universe, IPAddress target, uint16_t outUniverse)
+{
+  if (routeCount >= ART_MAX_ROUTES)
+    return false;
+
+  uint8_t o = 0;
+  while (o < outputCount && !(outputs[o].target == target && outputs[o].universe == outUniverse))
+    o++;
+  if (o == outputCount)
+  {
+    if (outputCount >= ART_MAX_FORWARD_OUTPUTS)
+      return false;
+    artnet_output_s &output = outputs[outputCount++];
+    output.target = target;
+    output.universe = outUniverse;
+    output.length = 0;
+    output.sequence = 0;
+    output.dirty = false;
+    output.merged = 0;
+  }
+
+  routes[routeCount].universe = universe;
+  routes[routeCount].output = o;
+  routeCount++;
+  return true;
+}
+
+// Queue received DMX data for the outputs it is routed to, sent by flush()
+void Artnet::forward(uint16_t universe, uint16_t length, const uint8_t *data)
+{
+  for (uint8_t r = 0; r < routeCount; r++)
+  {
+    if (routes[r].universe != universe)
+      continue;
+
+    artnet_output_s &output = outputs[routes[r].output];
+    uint16_t bit = 1 << r;
+
+    // The same route again before a flush, the frame has moved on without one
+    if (output.merged & bit)
+    {
+      sendOutput(output);
+    }
+
+    if (!output.dirty)
+    {
+      memcpy(output.data, data, length);
+      output.length = length;
+    }
+    else
+    {
+      uint16_t common = min(length, output.length);
+      for (uint16_t i = 0; i < common; i++)
+        output.data[i] = max(output.data[i], data[i]);
+      if (length > output.length)
       {
-        if (artSyncCallback) (*artSyncCallback)(remoteIP);
-        return ART_SYNC;
+        memcpy(output.data + common, data + common, length - common);
+        output.length = length;
       }
+    }
+    output.dirty = true;
+    output.merged |= bit;
   }
-  else
+}
+
+// Send every output written since the last flush, then one ArtSync to each
+// target so downstream nodes present the batch together. Returns the number
+// of universes sent.
+uint8_t Artnet::flush()
+{
+  bool synced[ART_MAX_FORWARD_OUTPUTS] = {};
+  uint8_t sent = 0;
+  for (uint8_t o = 0; o < outputCount; o++)
   {
+    if (!outputs[o].dirty)
+      continue;
+    sendOutput(outputs[o]);
+    synced[o] = true;
+    sent++;
+  }
+  if (sent == 0)
     return 0;
+
+  uint8_t syncPacket[ART_SYNC_SIZE] = {};
+  memcpy(syncPacket, ART_NET_ID, ART_NET_ID_SIZE);
+  syncPacket[8] = ART_SYNC & 0xFF;
+  syncPacket[9] = ART_SYNC >> 8;
+  syncPacket[11] = ART_NET_VERSION;
+  for (uint8_t o = 0; o < outputCount; o++)
+  {
+    if (!synced[o])
+      continue;
+    // Targets with several outputs get a single ArtSync
+    for (uint8_t later = o + 1; later < outputCount; later++)
+    {
+      if (outputs[later].target == outputs[o].target)
+        synced[later] = false;
+    }
+    send(outputs[o].target, syncPacket, sizeof(syncPacket));
   }
-  return 0;
+  return sent;
+}
+
+void Artnet::sendOutput(artnet_output_s &output)
+{
+  output.sequence = output.sequence == 255 ? 1 : output.sequence + 1;
+
+  uint8_t header[ART_DMX_START];
+  memcpy(header, ART_NET_ID, ART_NET_ID_SIZE);
+  header[8] = ART_DMX & 0xFF;
+  header[9] = ART_DMX >> 8;
+  header[10] = 0;
+  header[11] = ART_NET_VERSION;
+  header[12] = output.sequence;
+  header[13] = 0;
+  header[14] = output.universe & 0xFF;
+  header[15] = output.universe >> 8;
+  header[16] = output.length >> 8;
+  header[17] = output.length & 0xFF;
+
+  Udp.beginPacket(output.target, ART_NET_PORT);
+  Udp.write(header, sizeof(header));
+  Udp.write(output.data, output.length);
+  Udp.endPacket();
+
+  output.dirty = false;
+  output.merged = 0;
+  forwarded++;
 }
 
-void Artnet::printPacketHeader()
+FLASHMEM void Artnet::printPacketHeader()
 {
   Serial.print("packet size = ");
   Serial.print(packetSize);
@@ -173,7 +333,7 @@ void Artnet::printPacketHeader()
   Serial.println(sequence);
 }
 
-void Artnet::printPacketContent()
+FLASHMEM void Artnet::printPacketContent()
 {
   for (uint16_t i = ART_DMX_START ; i < dmxDataLength ; i++){
     Serial.print(artnetPacket[i], DEC);
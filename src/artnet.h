@@ -34,7 +34,16 @@
 #define MAX_BUFFER_ARTNET 1060 //530
 // Packet
 #define ART_NET_ID "Art-Net\0"
+#define ART_NET_ID_SIZE 8
+#define ART_NET_ID_WORD 0x0074654E2D747241ULL // ART_NET_ID read as a little-endian uint64_t
+#define ART_NET_VERSION 14
+#define ART_HEADER_SIZE 12
 #define ART_DMX_START 18
+#define ART_DMX_MAX_LENGTH 512
+#define ART_SYNC_SIZE 14
+// Forwarding
+#define ART_MAX_ROUTES 16
+#define ART_MAX_FORWARD_OUTPUTS 8
 
 struct artnet_reply_s {
   uint8_t  id[8];
@@ -74,6 +83,23 @@ struct artnet_reply_s {
   uint8_t  filler[26];
 } __attribute__((packed));
 
+// One received universe feeding a forwarded output
+struct artnet_route_s {
+  uint16_t universe;
+  uint8_t  output;
+};
+
+// A universe sent on to a downstream node, routes into the same output are merged HTP
+struct artnet_output_s {
+  IPAddress target;
+  uint16_t  universe;
+  uint16_t  length;
+  uint8_t   sequence;
+  bool      dirty;
+  uint16_t  merged; // Routes that have written this frame
+  uint8_t   data[ART_DMX_MAX_LENGTH];
+};
+
 class Artnet
 {
 public:
@@ -85,6 +111,10 @@ public:
   void setBroadcast(byte bc[]);
   void setBroadcast(IPAddress bc);
   uint16_t read();
+  void send(IPAddress ip, const uint8_t *data, uint16_t length);
+  bool addRoute(uint16_t universe, IPAddress target, uint16_t outUniverse);
+  void forward(uint16_t universe, uint16_t length, const uint8_t *data);
+  uint8_t flush();
   void printPacketHeader();
   void printPacketContent();
 
@@ -129,6 +159,21 @@ public:
     artSyncCallback = fptr;
   }
 
+  inline IPAddress getBroadcast(void)
+  {
+    return broadcast;
+  }
+
+  inline uint8_t getRouteCount(void)
+  {
+    return routeCount;
+  }
+
+  inline uint32_t getForwarded(void)
+  {
+    return forwarded;
+  }
+
 private:
   uint8_t  node_ip_address[4];
   uint8_t  id[8];
@@ -140,7 +185,7 @@ private:
   struct artnet_reply_s ArtPollReply;
 
 
-  uint8_t artnetPacket[MAX_BUFFER_ARTNET];
+  uint8_t artnetPacket[MAX_BUFFER_ARTNET] __attribute__((aligned(8)));
   uint16_t packetSize;
   IPAddress broadcast;
   uint16_t opcode;
@@ -150,6 +195,26 @@ private:
   IPAddress remoteIP;
   void (*artDmxCallback)(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t* data, IPAddress remoteIP);
   void (*artSyncCallback)(IPAddress remoteIP);
+
+  uint16_t handleDmx();
+  uint16_t handlePoll();
+  uint16_t handleSync();
+
+  artnet_route_s routes[ART_MAX_ROUTES];
+  uint8_t routeCount;
+  artnet_output_s outputs[ART_MAX_FORWARD_OUTPUTS];
+  uint8_t outputCount;
+  uint32_t forwarded;
+  void sendOutput(artnet_output_s &output);
+
+  struct opcode_handler_s {
+    uint16_t opcode;
+    uint16_t (Artnet::*handler)();
+  };
+  static const opcode_handler_s handlers[];
+  uint8_t dispatch[256]; // Opcode high byte to handlers[] index + 1, 0 = not handled
 };
 
+extern Artnet artnet; // Defined in main.cpp
+
 #endif
\ No newline at end of file
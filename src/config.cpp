@@ -5,23 +5,51 @@ IPAddress staticIP(192, 168, 1, 116);
 IPAddress subnetMask(255, 255, 255, 0);
 IPAddress gateway(192, 168, 1, 1);
 IPAddress broadcastIP(192, 168, 1, 255);
-String ledType = "WS2813";
-String colorOrder = "GRB";
+char ledType[8] = "WS2813";
+char colorOrder[4] = "GRB";
 uint16_t updateSpeed = 60; // Hz
+uint8_t lossAction = LOSS_HOLD;
+uint16_t lossTimeout = 2000; // ms
+uint16_t fadeTime = 3000; // ms
+uint32_t outputBudget = 0; // mA per output, 0 = unlimited
+uint32_t powerBudget = 0; // mA for the whole node, 0 = unlimited
+uint8_t syncMode = 0; // TIMESYNC_OFF
+uint8_t pixelFormat = PIXEL_RGB8;
+bool pixelPacking = false; // Let pixels span universes to use all 512 channels
+uint8_t previewRate = 10; // Hz, pixel preview snapshots, 0 = off
+IPAddress forwardIP(0, 0, 0, 0); // Downstream node for Art-Net forwarding, 0.0.0.0 = off
+uint16_t forwardFrom = 0; // First received universe to forward
+uint16_t forwardTo = 0; // Universe it is sent on as
+uint8_t forwardCount = 0; // Consecutive universes forwarded
 
 uint8_t mac[6] = { 0x04, 0xE9, 0xE5, 0x00, 0x00, 0x02 };  // Define mac here
 
-void saveSettingsToSD()
+FLASHMEM void saveSettingsToSD()
 {
+    // FILE_WRITE appends, start from an empty file
+    SD.remove("config.txt");
     File file = SD.open("config.txt", FILE_WRITE);
     if (file)
     {
-        file.println(ipToString(staticIP));
-        file.println(ipToString(subnetMask));
-        file.println(ipToString(gateway));
+        file.println(staticIP);
+        file.println(subnetMask);
+        file.println(gateway);
         file.println(ledType);
         file.println(colorOrder);
         file.println(updateSpeed);
+        file.println(lossAction);
+        file.println(lossTimeout);
+        file.println(fadeTime);
+        file.println(outputBudget);
+        file.println(powerBudget);
+        file.println(syncMode);
+        file.println(pixelFormat);
+        file.println(pixelPacking);
+        file.println(previewRate);
+        file.println(forwardIP);
+        file.println(forwardFrom);
+        file.println(forwardTo);
+        file.println(forwardCount);
         file.close();
         Serial.println("Settings saved to SD card.");
     }
@@ -31,46 +59,66 @@ void saveSettingsToSD()
     }
 }
 
-void loadSettingsFromSD()
+// Read one trimmed line into `line`, false at the end of the file
+static FLASHMEM bool readLine(File &file, char *line, size_t size)
+{
+    if (!file.available())
+    {
+        return false;
+    }
+    size_t n = file.readBytesUntil('\n', line, size - 1);
+    while (n > 0 && isspace((unsigned char)line[n - 1]))
+    {
+        n--;
+    }
+    line[n] = '\0';
+    return true;
+}
+
+FLASHMEM void loadSettingsFromSD()
 {
     File file = SD.open("config.txt");
     if (file)
     {
-        String line;
-        if (file.available())
-        {
-            line = file.readStringUntil('\n');
-            line.trim();
+        char line[32];
+        if (readLine(file, line, sizeof(line)))
             stringToIP(line, staticIP);
-        }
-        if (file.available())
-        {
-            line = file.readStringUntil('\n');
-            line.trim();
+        if (readLine(file, line, sizeof(line)))
             stringToIP(line, subnetMask);
-        }
-        if (file.available())
-        {
-            line = file.readStringUntil('\n');
-            line.trim();
+        if (readLine(file, line, sizeof(line)))
             stringToIP(line, gateway);
-        }
-        if (file.available())
-        {
-            ledType = file.readStringUntil('\n');
-            ledType.trim();
-        }
-        if (file.available())
-        {
-            colorOrder = file.readStringUntil('\n');
-            colorOrder.trim();
-        }
-        if (file.available())
-        {
-            line = file.readStringUntil('\n');
-            line.trim();
-            updateSpeed = line.toInt();
-        }
+        if (readLine(file, line, sizeof(line)))
+            snprintf(ledType, sizeof(ledType), "%s", line);
+        if (readLine(file, line, sizeof(line)))
+            snprintf(colorOrder, sizeof(colorOrder), "%s", line);
+        if (readLine(file, line, sizeof(line)))
+            updateSpeed = atoi(line);
+        if (readLine(file, line, sizeof(line)))
+            lossAction = atoi(line);
+        if (readLine(file, line, sizeof(line)))
+            lossTimeout = atoi(line);
+        if (readLine(file, line, sizeof(line)))
+            fadeTime = atoi(line);
+        if (readLine(file, line, sizeof(line)))
+            outputBudget = strtoul(line, NULL, 10);
+        if (readLine(file, line, sizeof(line)))
+            powerBudget = strtoul(line, NULL, 10);
+        if (readLine(file, line, sizeof(line)))
+            syncMode = atoi(line);
+        if (readLine(file, line, sizeof(line)))
+            pixelFormat = atoi(line);
+        if (readLine(file, line, sizeof(line)))
+            pixelPacking = atoi(line);
+        if (readLine(file, line, sizeof(line)))
+            previewRate = atoi(line);
+        if (readLine(file, line, sizeof(line)))
+            stringToIP(line, forwardIP);
+        if (readLine(file, line, sizeof(line)))
+            forwardFrom = atoi(line);
+        if (readLine(file, line, sizeof(line)))
+            forwardTo = atoi(line);
+        if (readLine(file, line, sizeof(line)))
+            forwardCount = min(max(atoi(line), 0), MAX_FORWARD_COUNT);
         file.close();
         Serial.println("Settings loaded from SD card.");
     }
@@ -80,29 +128,21 @@ void loadSettingsFromSD()
     }
 }
 
-String ipToString(IPAddress ip)
-{
-    return String(ip[0]) + "." +
-           String(ip[1]) + "." +
-           String(ip[2]) + "." +
-           String(ip[3]);
-}
-
-bool stringToIP(String str, IPAddress &ip)
+FLASHMEM bool stringToIP(const char *str, IPAddress &ip)
 {
     int parts[4];
     int part = 0;
-    int start = 0;
-    for (int i = 0; i <= str.length(); i++)
+    const char *p = str;
+    while (part < 4)
     {
-        if (str.charAt(i) == '.' || i == str.length())
-        {
-            String sub = str.substring(start, i);
-            parts[part++] = sub.toInt();
-            start = i + 1;
-            if (part > 3)
-                break;
-        }
+        char *end;
+        long value = strtol(p, &end, 10);
+        if (end == p || value < 0 || value > 255)
+            return false;
+        parts[part++] = value;
+        if (*end != '.')
+            break;
+        p = end + 1;
     }
     if (part != 4)
         return false;
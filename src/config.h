@@ -5,22 +5,50 @@
 #include <QNEthernet.h>
 #include <SD.h> // Add this line
 
+#include "artnet.h"
+
+// Loss-of-signal actions
+#define LOSS_HOLD 0
+#define LOSS_FADE 1
+#define LOSS_BLACKOUT 2
+#define LOSS_PLAYBACK 3
+
+// Pixel formats of the incoming DMX data
+#define PIXEL_RGB8 0
+#define PIXEL_RGBW8 1
+#define PIXEL_RGB16 2
+#define PIXEL_RGBW16 3
+
+// Each forwarded universe needs its own Art-Net output
+#define MAX_FORWARD_COUNT ART_MAX_FORWARD_OUTPUTS
 
 // Configuration variables
 extern IPAddress staticIP;
 extern IPAddress subnetMask;
 extern IPAddress gateway;
 extern IPAddress broadcastIP;
-extern String ledType;
-extern String colorOrder;
+extern char ledType[8];
+extern char colorOrder[4];
 extern uint16_t updateSpeed;
+extern uint8_t lossAction;
+extern uint16_t lossTimeout;
+extern uint16_t fadeTime;
+extern uint32_t outputBudget;
+extern uint32_t powerBudget;
+extern uint8_t syncMode;
+extern uint8_t pixelFormat;
+extern bool pixelPacking;
+extern uint8_t previewRate;
+extern IPAddress forwardIP;
+extern uint16_t forwardFrom;
+extern uint16_t forwardTo;
+extern uint8_t forwardCount;
 extern const int chipSelect;  // Add this line
 extern uint8_t mac[6];
 
 // Function prototypes
 void saveSettingsToSD();
 void loadSettingsFromSD();
-String ipToString(IPAddress ip);
-bool stringToIP(String str, IPAddress &ip);
+bool stringToIP(const char *str, IPAddress &ip);
 
 #endif // CONFIG_H
@@ -1,8 +1,26 @@
 #include "interface.h"
 #include "config.h"
+#include "show.h"
+#include "timesync.h"
+#include "planner.h"
+#include "netstats.h"
+#include "artnet.h"
 
 EthernetServer server(80); // Web server on port 80
 
+#define REQUEST_SIZE 512 // Longest request line handled, longer ones are cut off
+
+// Pixel preview state
+EthernetUDP previewUdp;
+static uint8_t previewPacket[sizeof(preview_header_s) + PREVIEW_DATA_SIZE];
+static uint16_t previewLength = 0; // 0 until the first snapshot
+static uint16_t previewSelect = PREVIEW_ALL;
+static unsigned long lastPreview = 0;
+static unsigned long webPreviewSeen = 0;
+static IPAddress monitorIP;
+static uint16_t monitorPort = 0;
+static unsigned long monitorSeen = 0;
+
 const char htmlPage[] PROGMEM = R"rawliteral(
 <!DOCTYPE html>
 <html>
@@ -35,41 +53,179 @@ const char htmlPage[] PROGMEM = R"rawliteral(
             <option value="BRG" %BRG_SELECTED%>BRG</option>
         </select><br><br>
 
+        <label for="pixelFormat">Pixel Format:</label>
+        <select id="pixelFormat" name="pixelFormat">
+            <option value="0" %PIXEL_RGB8_SELECTED%>RGB 8-bit</option>
+            <option value="1" %PIXEL_RGBW8_SELECTED%>RGBW 8-bit (SK6812)</option>
+            <option value="2" %PIXEL_RGB16_SELECTED%>RGB 16-bit</option>
+            <option value="3" %PIXEL_RGBW16_SELECTED%>RGBW 16-bit</option>
+        </select><br><br>
+
+        <label for="pixelPacking">Pack Pixels Across Universes:</label>
+        <select id="pixelPacking" name="pixelPacking">
+            <option value="0" %PACKING_OFF_SELECTED%>Off</option>
+            <option value="1" %PACKING_ON_SELECTED%>On</option>
+        </select><br><br>
+
         <label for="updateSpeed">Update Speed (Hz):</label>
         <input type="number" id="updateSpeed" name="updateSpeed" value="%UPDATE_SPEED%"><br><br>
 
+        <label for="lossAction">On Signal Loss:</label>
+        <select id="lossAction" name="lossAction">
+            <option value="0" %LOSS_HOLD_SELECTED%>Hold</option>
+            <option value="1" %LOSS_FADE_SELECTED%>Fade to black</option>
+            <option value="2" %LOSS_BLACKOUT_SELECTED%>Blackout</option>
+            <option value="3" %LOSS_PLAYBACK_SELECTED%>Play SD show</option>
+        </select><br><br>
+
+        <label for="lossTimeout">Signal Timeout (ms):</label>
+        <input type="number" id="lossTimeout" name="lossTimeout" value="%LOSS_TIMEOUT%"><br><br>
+
+        <label for="fadeTime">Fade Time (ms):</label>
+        <input type="number" id="fadeTime" name="fadeTime" value="%FADE_TIME%"><br><br>
+
+        <label for="outputBudget">Current Limit per Output (mA, 0 = off):</label>
+        <input type="number" id="outputBudget" name="outputBudget" value="%OUTPUT_BUDGET%"><br><br>
+
+        <label for="powerBudget">Total Current Limit (mA, 0 = off):</label>
+        <input type="number" id="powerBudget" name="powerBudget" value="%POWER_BUDGET%"><br><br>
+
+        <label for="syncMode">Time Sync:</label>
+        <select id="syncMode" name="syncMode">
+            <option value="0" %SYNC_OFF_SELECTED%>Off</option>
+            <option value="1" %SYNC_MASTER_SELECTED%>Master</option>
+            <option value="2" %SYNC_SLAVE_SELECTED%>Slave</option>
+        </select><br><br>
+
+        <label for="forwardIP">Forward to IP (0.0.0.0 = off):</label>
+        <input type="text" id="forwardIP" name="forwardIP" value="%FORWARD_IP%"><br><br>
+
+        <label for="forwardFrom">Forward Universes From:</label>
+        <input type="number" id="forwardFrom" name="forwardFrom" value="%FORWARD_FROM%"><br><br>
+
+        <label for="forwardTo">Send as Universe:</label>
+        <input type="number" id="forwardTo" name="forwardTo" value="%FORWARD_TO%"><br><br>
+
+        <label for="forwardCount">Universes to Forward:</label>
+        <input type="number" id="forwardCount" name="forwardCount" min="0" max="%FORWARD_MAX%" value="%FORWARD_COUNT%"><br><br>
+
+        <label for="previewRate">Pixel Preview Rate (Hz, 0 = off):</label>
+        <input type="number" id="previewRate" name="previewRate" value="%PREVIEW_RATE%"><br><br>
+
         <input type="submit" value="Submit">
     </form>
+
+    <h2>Show Recording</h2>
+    <p>Status: %SHOW_STATUS%</p>
+    <a href="/show?action=record">Record</a> |
+    <a href="/show?action=play">Play</a> |
+    <a href="/show?action=stop">Stop</a>
+
+    <h2>Time Sync</h2>
+    %SYNC_STATUS%
+
+    <h2>Frame Budget</h2>
+    %FRAME_PLAN%
+
+    <h2>Ingest Statistics</h2>
+    %NET_STATS%
+    <a href="/stats?action=reset">Reset</a>
+
+    <h2>Pixel Preview</h2>
+    <label for="previewUniverse">Universe (empty = all strips):</label>
+    <input type="number" id="previewUniverse" min="0"><br><br>
+    <canvas id="preview" width="768" height="160" style="background: #000"></canvas>
+    <script>
+    var previewInterval = %PREVIEW_INTERVAL%;
+    var canvas = document.getElementById('preview');
+    var ctx = canvas.getContext('2d');
+
+    // Header is preview_header_s, followed by rows * columns RGB pixels
+    function drawPreview(buffer) {
+        if (buffer.byteLength < 12) return;
+        var view = new DataView(buffer);
+        var rows = view.getUint8(6), columns = view.getUint16(8, true);
+        var w = canvas.width / columns, h = canvas.height / rows;
+        ctx.clearRect(0, 0, canvas.width, canvas.height);
+        for (var r = 0, i = 12; r < rows; r++) {
+            for (var c = 0; c < columns; c++, i += 3) {
+                ctx.fillStyle = 'rgb(' + view.getUint8(i) + ',' + view.getUint8(i + 1) + ',' + view.getUint8(i + 2) + ')';
+                ctx.fillRect(c * w, r * h + 2, Math.ceil(w), h - 4);
+            }
+        }
+    }
+
+    function pollPreview() {
+        var u = document.getElementById('previewUniverse').value;
+        fetch('/preview' + (u === '' ? '' : '?universe=' + u))
+            .then(function (response) { return response.arrayBuffer(); })
+            .then(drawPreview)
+            .catch(function () {})
+            .then(function () { setTimeout(pollPreview, previewInterval); });
+    }
+
+    if (previewInterval > 0) pollPreview();
+    </script>
 </body>
 </html>
 )rawliteral";
 
-void setupWebServer()
+FLASHMEM void setupWebServer()
 {
     server.begin();
+    previewUdp.begin(PREVIEW_PORT);
     Serial.print("Web server is at ");
     Serial.println(Ethernet.localIP());
 }
 
-void handleWebServer()
+FLASHMEM void handleWebServer()
 {
+    servicePreviewMonitor();
+
     EthernetClient client = server.available();
     if (client)
     {
+        char request[REQUEST_SIZE];
+        size_t n = client.readBytesUntil('\r', request, sizeof(request) - 1);
+        request[n] = '\0';
+
+        // The preview page polls several times a second, answer it without
+        // the serial log and the delay so loop() keeps its pace
+        if (strncmp(request, "GET /preview", 12) == 0)
+        {
+            handlePreviewRequest(request, client);
+            client.flush();
+            client.stop();
+            return;
+        }
+
         Serial.println("Client connected");
-        String request = client.readStringUntil('\r');
         Serial.println(request);
 
         // Serve the configuration page
-        if (request.indexOf("GET / ") >= 0)
+        if (strncmp(request, "GET / ", 6) == 0)
         {
             serveConfigPage(client);
         }
         // Handle form submission
-        else if (request.indexOf("GET /submit") >= 0)
+        else if (strncmp(request, "GET /submit", 11) == 0)
         {
             handleFormSubmission(request, client);
         }
+        // Reset ingest statistics between benchmark runs
+        else if (strncmp(request, "GET /stats?action=reset", 23) == 0)
+        {
+            netStats.reset();
+            client.println("HTTP/1.1 303 See Other");
+            client.println("Location: /");
+            client.println("Connection: close");
+            client.println();
+        }
+        // Record/play/stop the SD card show
+        else if (strncmp(request, "GET /show", 9) == 0)
+        {
+            handleShowRequest(request, client);
+        }
         // Not found
         else
         {
@@ -86,89 +242,311 @@ void handleWebServer()
     }
 }
 
-void serveConfigPage(EthernetClient &client)
+// The page is streamed straight from flash, placeholders are written out as
+// they are reached so no copy of the page is ever built on the heap
+FLASHMEM void serveConfigPage(EthernetClient &client)
+{
+    // Send the HTTP response
+    client.println("HTTP/1.1 200 OK");
+    client.println("Content-Type: text/html");
+    client.println("Connection: close");
+    client.println();
+
+    const char *p = htmlPage;
+    while (*p)
+    {
+        const char *start = strchr(p, '%');
+        const char *end = start ? strchr(start + 1, '%') : NULL;
+        if (!end)
+        {
+            client.print(p);
+            break;
+        }
+        client.write((const uint8_t *)p, start - p);
+
+        char name[32];
+        size_t len = min((size_t)(end - start - 1), sizeof(name) - 1);
+        memcpy(name, start + 1, len);
+        name[len] = '\0';
+        printPlaceholder(client, name);
+        p = end + 1;
+    }
+}
+
+static FLASHMEM void printSelected(Print &out, bool selected)
 {
-    String s = htmlPage;
+    if (selected)
+        out.print("selected");
+}
 
-    // Replace placeholders with actual values
-    s.replace("%IP%", ipToString(staticIP));
-    s.replace("%SUBNET%", ipToString(subnetMask));
-    s.replace("%GATEWAY%", ipToString(gateway));
-    s.replace("%UPDATE_SPEED%", String(updateSpeed));
+FLASHMEM void printPlaceholder(Print &out, const char *name)
+{
+    // Values
+    if (strcmp(name, "IP") == 0) out.print(staticIP);
+    else if (strcmp(name, "SUBNET") == 0) out.print(subnetMask);
+    else if (strcmp(name, "GATEWAY") == 0) out.print(gateway);
+    else if (strcmp(name, "UPDATE_SPEED") == 0) out.print(updateSpeed);
+    else if (strcmp(name, "LOSS_TIMEOUT") == 0) out.print(lossTimeout);
+    else if (strcmp(name, "FADE_TIME") == 0) out.print(fadeTime);
+    else if (strcmp(name, "OUTPUT_BUDGET") == 0) out.print(outputBudget);
+    else if (strcmp(name, "POWER_BUDGET") == 0) out.print(powerBudget);
+    else if (strcmp(name, "PREVIEW_RATE") == 0) out.print(previewRate);
+    else if (strcmp(name, "FORWARD_IP") == 0) out.print(forwardIP);
+    else if (strcmp(name, "FORWARD_FROM") == 0) out.print(forwardFrom);
+    else if (strcmp(name, "FORWARD_TO") == 0) out.print(forwardTo);
+    else if (strcmp(name, "FORWARD_COUNT") == 0) out.print(forwardCount);
+    else if (strcmp(name, "FORWARD_MAX") == 0) out.print(MAX_FORWARD_COUNT);
+    else if (strcmp(name, "PREVIEW_INTERVAL") == 0) out.print(previewRate ? 1000 / previewRate : 0);
 
     // LED Type selection
-    s.replace("%WS2811_SELECTED%", (ledType == "WS2811") ? "selected" : "");
-    s.replace("%WS2812_SELECTED%", (ledType == "WS2812") ? "selected" : "");
-    s.replace("%WS2813_SELECTED%", (ledType == "WS2813") ? "selected" : "");
+    else if (strcmp(name, "WS2811_SELECTED") == 0) printSelected(out, strcmp(ledType, "WS2811") == 0);
+    else if (strcmp(name, "WS2812_SELECTED") == 0) printSelected(out, strcmp(ledType, "WS2812") == 0);
+    else if (strcmp(name, "WS2813_SELECTED") == 0) printSelected(out, strcmp(ledType, "WS2813") == 0);
 
     // Color Order selection
-    s.replace("%GRB_SELECTED%", (colorOrder == "GRB") ? "selected" : "");
-    s.replace("%RGB_SELECTED%", (colorOrder == "RGB") ? "selected" : "");
-    s.replace("%BRG_SELECTED%", (colorOrder == "BRG") ? "selected" : "");
+    else if (strcmp(name, "GRB_SELECTED") == 0) printSelected(out, strcmp(colorOrder, "GRB") == 0);
+    else if (strcmp(name, "RGB_SELECTED") == 0) printSelected(out, strcmp(colorOrder, "RGB") == 0);
+    else if (strcmp(name, "BRG_SELECTED") == 0) printSelected(out, strcmp(colorOrder, "BRG") == 0);
 
-    // Send the HTTP response
-    client.println("HTTP/1.1 200 OK");
-    client.println("Content-Type: text/html");
-    client.println("Connection: close");
-    client.println();
-    client.print(s);
+    // Pixel format selection
+    else if (strcmp(name, "PIXEL_RGB8_SELECTED") == 0) printSelected(out, pixelFormat == PIXEL_RGB8);
+    else if (strcmp(name, "PIXEL_RGBW8_SELECTED") == 0) printSelected(out, pixelFormat == PIXEL_RGBW8);
+    else if (strcmp(name, "PIXEL_RGB16_SELECTED") == 0) printSelected(out, pixelFormat == PIXEL_RGB16);
+    else if (strcmp(name, "PIXEL_RGBW16_SELECTED") == 0) printSelected(out, pixelFormat == PIXEL_RGBW16);
+    else if (strcmp(name, "PACKING_OFF_SELECTED") == 0) printSelected(out, !pixelPacking);
+    else if (strcmp(name, "PACKING_ON_SELECTED") == 0) printSelected(out, pixelPacking);
+
+    // Loss-of-signal action selection
+    else if (strcmp(name, "LOSS_HOLD_SELECTED") == 0) printSelected(out, lossAction == LOSS_HOLD);
+    else if (strcmp(name, "LOSS_FADE_SELECTED") == 0) printSelected(out, lossAction == LOSS_FADE);
+    else if (strcmp(name, "LOSS_BLACKOUT_SELECTED") == 0) printSelected(out, lossAction == LOSS_BLACKOUT);
+    else if (strcmp(name, "LOSS_PLAYBACK_SELECTED") == 0) printSelected(out, lossAction == LOSS_PLAYBACK);
+
+    // Time sync selection
+    else if (strcmp(name, "SYNC_OFF_SELECTED") == 0) printSelected(out, syncMode == TIMESYNC_OFF);
+    else if (strcmp(name, "SYNC_MASTER_SELECTED") == 0) printSelected(out, syncMode == TIMESYNC_MASTER);
+    else if (strcmp(name, "SYNC_SLAVE_SELECTED") == 0) printSelected(out, syncMode == TIMESYNC_SLAVE);
+
+    // Status sections
+    else if (strcmp(name, "SYNC_STATUS") == 0) printSyncStatus(out);
+    else if (strcmp(name, "FRAME_PLAN") == 0) printFramePlan(out);
+    else if (strcmp(name, "NET_STATS") == 0) printNetStats(out);
+    else if (strcmp(name, "SHOW_STATUS") == 0)
+    {
+        if (showRecorder.isRecording())
+            out.print("Recording");
+        else if (showPlayer.isPlaying())
+            out.print("Playing");
+        else
+            out.print("Idle");
+    }
 }
 
-void handleFormSubmission(String request, EthernetClient &client)
+FLASHMEM void printSyncStatus(Print &out)
+{
+    if (timeSync.getMode() == TIMESYNC_SLAVE)
+    {
+        if (!timeSync.isSynced())
+        {
+            out.print("<p>Waiting for master</p>");
+            return;
+        }
+        out.printf("<p>Offset: %ld us, drift: %ld ppb, delay: %lu us, jitter: %lu us</p>",
+                   (long)timeSync.getOffset(), (long)timeSync.getDrift(),
+                   (unsigned long)timeSync.getDelay(), (unsigned long)timeSync.getJitter());
+        return;
+    }
+    if (timeSync.getMode() != TIMESYNC_MASTER)
+    {
+        out.print("<p>Off</p>");
+        return;
+    }
+
+    // Error is how far each slave's shared clock is from this master's
+    out.printf("<p>Skew between nodes: %lu us</p>", (unsigned long)timeSync.getSkew());
+    out.print("<table><tr><th>Node</th><th>Offset (us)</th><th>Error (us)</th></tr>");
+    for (uint8_t i = 0; i < timeSync.getNodeCount(); i++)
+    {
+        const timesync_node_s &node = timeSync.getNode(i);
+        out.print("<tr><td>");
+        out.print(node.ip);
+        if (timeSync.isLive(node))
+            out.printf("</td><td>%ld</td><td>%ld</td></tr>", (long)node.offset, (long)node.error);
+        else
+            out.printf("</td><td>%ld</td><td>-</td></tr>", (long)node.offset);
+    }
+    out.print("</table>");
+}
+
+FLASHMEM void printFramePlan(Print &out)
+{
+    frame_plan_s plan = currentFramePlan();
+    out.print("<table>");
+    out.printf("<tr><td>Pixel data</td><td>%lu us</td></tr>", (unsigned long)plan.transmitUs);
+    out.printf("<tr><td>Reset latch</td><td>%lu us</td></tr>", (unsigned long)plan.latchUs);
+    out.printf("<tr><td>show() (avg / max)</td><td>%lu / %lu us</td></tr>",
+               (unsigned long)plan.setupUs, (unsigned long)cyclesToMicros(showTiming.max));
+    out.printf("<tr><td>Ingest per universe (avg / max)</td><td>%lu / %lu us</td></tr>",
+               (unsigned long)plan.ingestUs, (unsigned long)cyclesToMicros(ingestTiming.max));
+    out.printf("<tr><td>Output time per frame</td><td>%lu us</td></tr>", (unsigned long)plan.outputUs);
+    out.printf("<tr><td>CPU time per frame</td><td>%lu us</td></tr>", (unsigned long)plan.cpuUs);
+    out.printf("<tr><td>Max refresh rate</td><td>%u fps</td></tr>", plan.maxFps);
+    out.printf("<tr><td>Headroom at %u Hz</td><td>%d %%</td></tr>", updateSpeed, plan.headroom);
+    out.print("</table>");
+}
+
+FLASHMEM void printNetStats(Print &out)
+{
+    out.print("<table>");
+    out.printf("<tr><td>Packets</td><td>%lu</td></tr>", (unsigned long)netStats.getPackets());
+    out.printf("<tr><td>Packet rate</td><td>%lu /s</td></tr>", (unsigned long)netStats.getPacketRate());
+    out.printf("<tr><td>Dropped</td><td>%lu</td></tr>", (unsigned long)netStats.getDropped());
+    out.printf("<tr><td>Reordered</td><td>%lu</td></tr>", (unsigned long)netStats.getReordered());
+    out.printf("<tr><td>Frames shown</td><td>%lu</td></tr>", (unsigned long)netStats.getFrames());
+    out.printf("<tr><td>Packet-to-pixel p50</td><td>%lu us</td></tr>", (unsigned long)netStats.getLatencyPercentile(50));
+    out.printf("<tr><td>Packet-to-pixel p99</td><td>%lu us</td></tr>", (unsigned long)netStats.getLatencyPercentile(99));
+    uint8_t requested = (uint32_t)forwardIP != 0 ? forwardCount : 0;
+    if (artnet.getRouteCount() < requested)
+        out.printf("<tr><td>Forward routes</td><td>%u (%u rejected)</td></tr>", artnet.getRouteCount(), requested - artnet.getRouteCount());
+    else
+        out.printf("<tr><td>Forward routes</td><td>%u</td></tr>", artnet.getRouteCount());
+    out.printf("<tr><td>Forwarded universes</td><td>%lu</td></tr>", (unsigned long)artnet.getForwarded());
+    out.printf("<tr><td>Forward flush (avg / max)</td><td>%lu / %lu us</td></tr>",
+               (unsigned long)cyclesToMicros(forwardTiming.avg), (unsigned long)cyclesToMicros(forwardTiming.max));
+    out.print("</table>");
+}
+
+// Decode %XX escapes and '+' in place
+static FLASHMEM void urlDecode(char *s)
+{
+    char *out = s;
+    for (; *s; s++)
+    {
+        if (*s == '%' && isxdigit((unsigned char)s[1]) && isxdigit((unsigned char)s[2]))
+        {
+            char hex[3] = {s[1], s[2], '\0'};
+            *out++ = strtol(hex, NULL, 16);
+            s += 2;
+        }
+        else
+        {
+            *out++ = *s == '+' ? ' ' : *s;
+        }
+    }
+    *out = '\0';
+}
+
+FLASHMEM void handleFormSubmission(char *request, EthernetClient &client)
 {
     // Parse the request
-    int paramsStart = request.indexOf("GET /submit?") + String("GET /submit?").length();
-    int paramsEnd = request.indexOf(" ", paramsStart);
-    String params = request.substring(paramsStart, paramsEnd);
+    char *params = strchr(request, '?');
+    if (params == NULL)
+    {
+        params = request + strlen(request);
+    }
+    else
+    {
+        params++;
+    }
+    char *paramsEnd = strchr(params, ' ');
+    if (paramsEnd != NULL)
+    {
+        *paramsEnd = '\0';
+    }
 
     // Split parameters
-    char paramArray[params.length() + 1];
-    params.toCharArray(paramArray, params.length() + 1);
-    char *token = strtok(paramArray, "&");
+    char *save;
+    char *token = strtok_r(params, "&", &save);
     while (token != NULL)
     {
-        String pair = String(token);
-        int equalPos = pair.indexOf('=');
-        if (equalPos > 0)
+        char *value = strchr(token, '=');
+        if (value != NULL && value > token)
         {
-            String key = pair.substring(0, equalPos);
-            String value = pair.substring(equalPos + 1);
+            *value++ = '\0';
+            const char *key = token;
 
             // Decode URL encoding
-            value.replace("%3A", ":");
-            value.replace("%2E", ".");
-            value.replace("%2F", "/");
-            value.replace("%2C", ",");
-            value.replace("%20", " ");
-            value.replace("+", " ");
+            urlDecode(value);
 
             // Update configuration variables
-            if (key == "ip")
+            if (strcmp(key, "ip") == 0)
             {
                 stringToIP(value, staticIP);
             }
-            else if (key == "subnet")
+            else if (strcmp(key, "subnet") == 0)
             {
                 stringToIP(value, subnetMask);
             }
-            else if (key == "gateway")
+            else if (strcmp(key, "gateway") == 0)
             {
                 stringToIP(value, gateway);
             }
-            else if (key == "ledtype")
+            else if (strcmp(key, "ledtype") == 0)
+            {
+                snprintf(ledType, sizeof(ledType), "%s", value);
+            }
+            else if (strcmp(key, "colororder") == 0)
+            {
+                snprintf(colorOrder, sizeof(colorOrder), "%s", value);
+            }
+            else if (strcmp(key, "updateSpeed") == 0)
+            {
+                updateSpeed = atoi(value);
+            }
+            else if (strcmp(key, "lossAction") == 0)
+            {
+                lossAction = atoi(value);
+            }
+            else if (strcmp(key, "lossTimeout") == 0)
+            {
+                lossTimeout = atoi(value);
+            }
+            else if (strcmp(key, "fadeTime") == 0)
+            {
+                fadeTime = atoi(value);
+            }
+            else if (strcmp(key, "outputBudget") == 0)
+            {
+                outputBudget = strtoul(value, NULL, 10);
+            }
+            else if (strcmp(key, "powerBudget") == 0)
             {
-                ledType = value;
+                powerBudget = strtoul(value, NULL, 10);
             }
-            else if (key == "colororder")
+            else if (strcmp(key, "syncMode") == 0)
             {
-                colorOrder = value;
+                syncMode = atoi(value);
             }
-            else if (key == "updateSpeed")
+            else if (strcmp(key, "pixelFormat") == 0)
             {
-                updateSpeed = value.toInt();
+                pixelFormat = atoi(value);
+            }
+            else if (strcmp(key, "pixelPacking") == 0)
+            {
+                pixelPacking = atoi(value);
+            }
+            else if (strcmp(key, "previewRate") == 0)
+            {
+                previewRate = atoi(value);
+            }
+            else if (strcmp(key, "forwardIP") == 0)
+            {
+                stringToIP(value, forwardIP);
+            }
+            else if (strcmp(key, "forwardFrom") == 0)
+            {
+                forwardFrom = atoi(value);
+            }
+            else if (strcmp(key, "forwardTo") == 0)
+            {
+                forwardTo = atoi(value);
+            }
+            else if (strcmp(key, "forwardCount") == 0)
+            {
+                forwardCount = min(max(atoi(value), 0), MAX_FORWARD_COUNT);
             }
         }
-        token = strtok(NULL, "&");
+        token = strtok_r(NULL, "&", &save);
     }
 
     // Save settings to SD card
@@ -186,7 +564,7 @@ void handleFormSubmission(String request, EthernetClient &client)
     // JavaScript to redirect after a delay
     client.println("<script type=\"text/javascript\">");
     client.println("setTimeout(function(){ window.location.href = 'http://");
-    client.print(ipToString(staticIP));
+    client.print(staticIP);
     client.println("/'; }, 15000);"); // Redirect after 15 seconds
     client.println("</script>");
     client.println("</head>");
@@ -202,3 +580,137 @@ void handleFormSubmission(String request, EthernetClient &client)
     // Reboot to apply new settings
     SCB_AIRCR = 0x05FA0004; // System reset request
 }
+
+FLASHMEM void handleShowRequest(const char *request, EthernetClient &client)
+{
+    if (strstr(request, "action=record") != NULL)
+    {
+        showPlayer.end();
+        showRecorder.begin(SHOW_FILE);
+    }
+    else if (strstr(request, "action=play") != NULL)
+    {
+        showRecorder.end();
+        showPlayer.begin(SHOW_FILE, true);
+    }
+    else if (strstr(request, "action=stop") != NULL)
+    {
+        showRecorder.end();
+        showPlayer.end();
+    }
+
+    // Back to the configuration page
+    client.println("HTTP/1.1 303 See Other");
+    client.println("Location: /");
+    client.println("Connection: close");
+    client.println();
+}
+
+FLASHMEM void handlePreviewRequest(const char *request, EthernetClient &client)
+{
+    // Polling the page keeps the preview running, the last request picks the universe
+    const char *universe = strstr(request, "universe=");
+    previewSelect = universe != NULL ? atoi(universe + 9) : PREVIEW_ALL;
+    webPreviewSeen = millis();
+
+    client.println("HTTP/1.1 200 OK");
+    client.println("Content-Type: application/octet-stream");
+    client.println("Cache-Control: no-store");
+    client.print("Content-Length: ");
+    client.println(previewLength);
+    client.println("Connection: close");
+    client.println();
+    client.write(previewPacket, previewLength);
+}
+
+void servicePreviewMonitor()
+{
+    if (previewUdp.parsePacket() <= 0)
+    {
+        return;
+    }
+
+    uint8_t request[6];
+    int length = previewUdp.read(request, sizeof(request));
+    if (length < 4 || memcmp(request, PREVIEW_MAGIC, 4) != 0)
+    {
+        return;
+    }
+    monitorIP = previewUdp.remoteIP();
+    monitorPort = previewUdp.remotePort();
+    monitorSeen = millis();
+    previewSelect = length >= 6 ? request[4] | request[5] << 8 : PREVIEW_ALL;
+}
+
+static bool monitorActive(unsigned long currentTime)
+{
+    return monitorPort != 0 && currentTime - monitorSeen < PREVIEW_TIMEOUT;
+}
+
+// Snapshots are only taken while someone is watching, at most previewRate times a second
+bool previewDue(unsigned long currentTime)
+{
+    if (previewRate == 0 || currentTime - lastPreview < 1000u / previewRate)
+    {
+        return false;
+    }
+    bool webActive = webPreviewSeen != 0 && currentTime - webPreviewSeen < PREVIEW_TIMEOUT;
+    return webActive || monitorActive(currentTime);
+}
+
+uint16_t previewUniverse()
+{
+    return previewSelect;
+}
+
+// Downsample pixels [first, end) of `strips` strips into the preview packet,
+// each column is the average of the pixels it covers with white folded into RGB
+void capturePreview(OctoWS2811 &leds, uint16_t universe, int ledsPerStrip, int firstStrip, int strips, int first, int end)
+{
+    unsigned long currentTime = millis();
+    lastPreview = currentTime;
+
+    int pixels = end - first;
+    if (strips <= 0 || pixels <= 0)
+    {
+        return;
+    }
+    int columns = min(pixels, PREVIEW_DATA_SIZE / (strips * 3));
+
+    preview_header_s *header = (preview_header_s *)previewPacket;
+    memcpy(header->magic, PREVIEW_MAGIC, sizeof(header->magic));
+    header->universe = universe;
+    header->rows = strips;
+    header->reserved = 0;
+    header->columns = columns;
+    header->pixels = pixels;
+
+    uint8_t *out = previewPacket + sizeof(preview_header_s);
+    for (int s = firstStrip; s < firstStrip + strips; s++)
+    {
+        for (int c = 0; c < columns; c++)
+        {
+            int from = first + c * pixels / columns;
+            int to = first + (c + 1) * pixels / columns;
+            uint32_t sum[3] = {0, 0, 0};
+            for (int p = from; p < to; p++)
+            {
+                uint32_t color = leds.getPixel(s * ledsPerStrip + p);
+                uint32_t white = color >> 24;
+                sum[0] += min(((color >> 16) & 0xFF) + white, 255u);
+                sum[1] += min(((color >> 8) & 0xFF) + white, 255u);
+                sum[2] += min((color & 0xFF) + white, 255u);
+            }
+            for (int i = 0; i < 3; i++)
+            {
+                *out++ = sum[i] / (to - from);
+            }
+        }
+    }
+    previewLength = out - previewPacket;
+
+    if (monitorActive(currentTime))
+    {
+        previewUdp.send(monitorIP, monitorPort, previewPacket, previewLength);
+    }
+}
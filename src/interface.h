@@ -3,12 +3,43 @@
 
 #include <Arduino.h>
 #include <QNEthernet.h>
+#include <OctoWS2811.h>
 
 using namespace qindesign::network;
 
+// Pixel preview: downsampled snapshots of the pixel buffer, served to the
+// web page on /preview and streamed to a UDP monitor on PREVIEW_PORT. A
+// monitor subscribes by sending "LNPV" plus an optional little-endian
+// universe, and has to repeat that within PREVIEW_TIMEOUT to keep receiving.
+#define PREVIEW_PORT 6455
+#define PREVIEW_MAGIC "LNPV"
+#define PREVIEW_ALL 0xFFFF // Every strip instead of one universe
+#define PREVIEW_DATA_SIZE 1536 // RGB bytes per snapshot, columns shrink to fit
+#define PREVIEW_TIMEOUT 5000 // ms
+
+// Followed by rows * columns RGB pixels
+struct preview_header_s {
+  uint8_t  magic[4];
+  uint16_t universe;
+  uint8_t  rows;
+  uint8_t  reserved;
+  uint16_t columns;
+  uint16_t pixels; // Pixels per row before downsampling
+} __attribute__((packed));
+
 void setupWebServer();
 void handleWebServer();
 void serveConfigPage(EthernetClient &client);
-void handleFormSubmission(String request, EthernetClient &client);
+void printPlaceholder(Print &out, const char *name);
+void printSyncStatus(Print &out);
+void printFramePlan(Print &out);
+void printNetStats(Print &out);
+void handleFormSubmission(char *request, EthernetClient &client);
+void handleShowRequest(const char *request, EthernetClient &client);
+void handlePreviewRequest(const char *request, EthernetClient &client);
+void servicePreviewMonitor();
+bool previewDue(unsigned long currentTime);
+uint16_t previewUniverse();
+void capturePreview(OctoWS2811 &leds, uint16_t universe, int ledsPerStrip, int firstStrip, int strips, int first, int end);
 
 #endif // INTERFACE_H
@@ -17,6 +17,10 @@
 #include "artnet.h"
 #include "interface.h"
 #include "config.h"
+#include "show.h"
+#include "timesync.h"
+#include "planner.h"
+#include "netstats.h"
 
 using namespace qindesign::network;
 
@@ -28,7 +32,6 @@ extern "C" uint32_t set_arm_clock(uint32_t frequency);
 //  Configuration
 // --------------------------------------------------------------------------
 #define NUM_STRIPS 5
-#define CHANNELS_PER_LED 3
 #define PIN_LED_STATUS 35
 #define PIN_LED_DMX 34
 #define PIN_LED_POLL 33
@@ -37,12 +40,64 @@ extern "C" uint32_t set_arm_clock(uint32_t frequency);
 
 byte PIN_LED_DATA[] = {23, 22, 21, 20, 19};
 
-const int num_leds_pr_out = 512 * UNIVERSES_BY_OUT / CHANNELS_PER_LED;
 const int maxUniverses = NUM_STRIPS * UNIVERSES_BY_OUT;
-unsigned long lastUpdate = 0;
 
-DMAMEM int displayMemory[num_leds_pr_out * NUM_STRIPS * CHANNELS_PER_LED / 4];
-int drawingMemory[num_leds_pr_out * NUM_STRIPS * CHANNELS_PER_LED / 4];
+// Memory placement (scripts/memory_report.py prints the totals after each build):
+//  - Everything touched per packet or per frame stays in plain globals, which
+//    the Teensy 4.1 linker puts in DTCM (RAM1): the Artnet packet buffer,
+//    channelStream, drawingMemory and the routing/arrival state below.
+//  - Buffers only touched on signal loss or by the SD show code live in
+//    DMAMEM (OCRAM, RAM2), leaving DTCM for the hot data and the stack.
+//  - displayMemory is DMAMEM as well; OctoWS2811 flushes the cache for the
+//    bit buffers it hands to the DMA, so no extra maintenance is needed here.
+//  - Setup and web interface code is FLASHMEM, keeping ITCM for the ingest path.
+
+// Pixel layout, set from pixelFormat/pixelPacking in initializeLEDs()
+int num_leds_pr_out = 512 * UNIVERSES_BY_OUT / 3;
+uint8_t pixelChannels = 3;  // Output channels per pixel, RGB or RGBW
+uint8_t pixelBytes = 3;     // DMX channels per pixel, 2 per colour for 16-bit input
+bool pixelWide = false;     // 16-bit input, dithered down to 8 bits
+int pixelsPerUniverse = 170;
+uint8_t ditherPhase = 0;
+const uint8_t ditherPattern[8] = {0, 128, 64, 192, 32, 160, 96, 224};
+
+// Packed pixels run across universe boundaries, so each strip keeps the
+// channels of all its universes to rebuild the pixels that straddle them
+uint8_t channelStream[NUM_STRIPS][512 * UNIVERSES_BY_OUT];
+unsigned long lastUpdate = 0;
+uint32_t lastFrameTick = 0;
+bool outputDirty = true;
+
+// Loss-of-signal state per routed universe
+#define SIGNAL_NONE 0
+#define SIGNAL_LIVE 1
+#define SIGNAL_LOST 2
+uint8_t universeState[maxUniverses];
+unsigned long universeLastSeen[maxUniverses];
+unsigned long fadeStart[maxUniverses];
+#define MAX_UNIVERSE_BYTES 516 // Largest pixel buffer span of one universe, 171 packed RGB pixels
+DMAMEM uint8_t fadeFrom[maxUniverses][MAX_UNIVERSE_BYTES];
+bool fading[maxUniverses];
+bool lossPlayback = false;
+
+// Universes that have arrived for the frame being assembled, one bit per universe of each strip
+uint16_t stripArrived[NUM_STRIPS];
+bool frameComplete = false;
+
+// Current estimate, summed channel values per routed universe
+#define LED_MA_PER_CHANNEL 20 // mA drawn by one channel at full brightness
+#define LED_MA_IDLE 1 // mA drawn by one dark pixel
+uint32_t universeLevel[maxUniverses];
+
+// Every pixel format fits in the 512 bytes per universe of a strip
+DMAMEM int displayMemory[512 * UNIVERSES_BY_OUT * NUM_STRIPS / 4];
+int drawingMemory[512 * UNIVERSES_BY_OUT * NUM_STRIPS / 4];
+
+// The limiter scales the drawing buffer only for the show() that copies it
+// out, the unscaled pixels are kept here and put back right after so the
+// next frame starts from the source data again
+uint8_t limitBackup[sizeof(drawingMemory)];
+bool stripLimited[NUM_STRIPS];
 const int config = WS2811_GRB | WS2811_800kHz;
 
 OctoWS2811 leds(num_leds_pr_out, displayMemory, drawingMemory, config, NUM_STRIPS, PIN_LED_DATA);
@@ -57,6 +112,21 @@ Artnet artnet;
 //  Declarations
 // --------------------------------------------------------------------------
 void onDmxFrame(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t *data, IPAddress remoteIP);
+void onShowFrame(uint16_t universe, uint16_t length, uint8_t *data);
+bool frameDue(unsigned long currentTime);
+bool writeUniverse(uint16_t universe, uint16_t length, uint8_t *data);
+uint32_t convertPixels(int pixel, int count, const uint8_t *src, int sumFrom);
+void universePixelRange(int slot, int *first, int *end);
+uint8_t *universePixels(int slot, uint16_t *bytes);
+void checkSignalLoss(unsigned long currentTime);
+void updateFades(unsigned long currentTime);
+void limitPower();
+void restorePower();
+void presentFrame();
+void trackArrival(int slot);
+bool frameArriving();
+void updatePreview();
+void forwardFrame();
 void updateLEDs();
 void initializeLEDs();
 void initializeArtNet();
@@ -77,7 +147,7 @@ void turnOffLEDPoll()
 // --------------------------------------------------------------------------
 //  Main Setup
 // --------------------------------------------------------------------------
-void setup()
+FLASHMEM void setup()
 {
     set_arm_clock(600000000); // Set Teensy clock to 600 MHz
     delay(1000);
@@ -100,9 +170,13 @@ void setup()
 
     // Initialize OctoWS2811 with the loaded settings
     initializeLEDs();
+    setFrameConfig(num_leds_pr_out, NUM_STRIPS, pixelChannels, maxUniverses);
 
     //initialize artnet server
     initializeArtNet();
+
+    // Recorded show playback feeds the same routing as live ArtDmx
+    showPlayer.setFrameCallback(onShowFrame);
     
     // Set up web server for user interface
     setupWebServer();
@@ -116,16 +190,42 @@ void setup()
 void loop()
 {
     unsigned long currentTime = millis();
-    if (currentTime - lastUpdate >= (1000 / 60)); //(1000 / updateSpeed))
+    checkSignalLoss(currentTime);
+
+    // Only refresh the strips when something changed, a static output costs nothing
+    if (frameDue(currentTime))
     {
-        updateLEDs();
+        updateFades(currentTime);
+        presentFrame();
+        // Mid-frame the rest is still on its way, frame completion or ArtSync
+        // forwards it whole instead of tearing it across two syncs
+        if (!frameArriving())
+        {
+            forwardFrame();
+        }
         lastUpdate = currentTime;
     }
 
     // Handle ArtNet data
+    uint32_t readStart = ARM_DWT_CYCCNT;
     uint16_t packetType = artnet.read();
     if (packetType == ART_DMX)
     {
+        recordTiming(ingestTiming, ARM_DWT_CYCCNT - readStart);
+
+        // Present as soon as the last universe of the frame lands instead of
+        // waiting for the next tick. The shared time base owns presentation
+        // when time sync is running.
+        if (frameComplete)
+        {
+            frameComplete = false;
+            memset(stripArrived, 0, sizeof(stripArrived));
+            if (!timeSync.isSynced())
+            {
+                presentFrame();
+            }
+            forwardFrame();
+        }
         digitalWrite(PIN_LED_DMX, HIGH);
         dmxTimer.begin(turnOffLEDDmx, 5000); // 5ms
     }
@@ -134,6 +234,23 @@ void loop()
         digitalWrite(PIN_LED_POLL, HIGH);
         pollTimer.begin(turnOffLEDPoll, 100000); // 200ms
     }
+    // The upstream frame is complete, pass it on without waiting for the tick
+    else if (packetType == ART_SYNC)
+    {
+        forwardFrame();
+    }
+    // Preview snapshots are only taken when no packet was waiting, so they
+    // never hold up ingest or a frame
+    else if (packetType == 0 && previewDue(currentTime))
+    {
+        updatePreview();
+    }
+
+    timeSync.service();
+
+    // Stream recorded show data to/from the SD card
+    showRecorder.service();
+    showPlayer.service();
 
     handleWebServer(); // Call this to handle web server requests
 }
@@ -143,67 +260,428 @@ void loop()
 // --------------------------------------------------------------------------
 void onDmxFrame(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t *data, IPAddress remoteIP)
 {
-    int stripIndex = (universe - START_UNIVERSE) / UNIVERSES_BY_OUT;
-    if (stripIndex < 0 || stripIndex >= NUM_STRIPS)
+    // Forwarded universes don't have to be routed to the strips
+    artnet.forward(universe, length, data);
+
+    if (!writeUniverse(universe, length, data))
     {
         return;
     }
 
-    int ledOffset = (universe % UNIVERSES_BY_OUT) * (512 / CHANNELS_PER_LED);
+    int slot = universe - START_UNIVERSE;
+    trackArrival(slot);
+    universeState[slot] = SIGNAL_LIVE;
+    universeLastSeen[slot] = millis();
+    netStats.onPacket(slot, sequence, micros());
+    fading[slot] = false;
+
+    // Live data for this node always takes over from a playing show,
+    // other nodes' universes on a broadcast network must not stop it
+    if (showPlayer.isPlaying())
+    {
+        showPlayer.end();
+    }
+    lossPlayback = false;
 
-    Serial.print("DMX data received: ");
-    Serial.print("Universe ");
-    Serial.print(universe);
-    Serial.print(", StripIndex ");
-    Serial.print(stripIndex);
-    // Serial.print(", LedOffset: ");
-    // Serial.print(ledOffset);
-    Serial.println();
+    showRecorder.capture(universe, length, data);
+}
 
-    for (int i = 0; i < min(length / CHANNELS_PER_LED, num_leds_pr_out); i++)
+void onShowFrame(uint16_t universe, uint16_t length, uint8_t *data)
+{
+    writeUniverse(universe, length, data);
+}
+
+// With time sync running, frames fall on a grid of the shared clock so every
+// node presents at the same instant; otherwise use the local clock.
+bool frameDue(unsigned long currentTime)
+{
+    uint32_t interval = 1000000 / max(updateSpeed, (uint16_t)1);
+    if (timeSync.isSynced())
     {
-        int actualLedIndex = ledOffset + i;
-        leds.setPixel((stripIndex * num_leds_pr_out) + actualLedIndex,
-                      data[i * CHANNELS_PER_LED],
-                      data[i * CHANNELS_PER_LED + 1],
-                      data[i * CHANNELS_PER_LED + 2]);
+        uint32_t tick = timeSync.now() / interval;
+        if (tick == lastFrameTick)
+        {
+            return false;
+        }
+        lastFrameTick = tick;
+        return true;
     }
+    return currentTime - lastUpdate >= interval / 1000;
 }
 
-void updateLEDs()
+bool writeUniverse(uint16_t universe, uint16_t length, uint8_t *data)
 {
-    leds.show();
+    int slot = universe - START_UNIVERSE;
+    if (slot < 0 || slot >= maxUniverses)
+    {
+        return false;
+    }
+
+    int stripIndex = slot / UNIVERSES_BY_OUT;
+    int first, end;
+    universePixelRange(slot, &first, &end);
+    length = min(length, (uint16_t)512);
+
+    // Sum the channels while copying so the power limiter needs no extra pass
+    uint32_t level;
+    if (pixelPacking)
+    {
+        // Rebuild from the first pixel that has channels in this universe,
+        // which may have started in the previous one
+        int base = (slot % UNIVERSES_BY_OUT) * 512;
+        memcpy(channelStream[stripIndex] + base, data, length);
+        int start = base / pixelBytes;
+        int stop = min((base + length + pixelBytes - 1) / pixelBytes, num_leds_pr_out);
+        level = convertPixels(stripIndex * num_leds_pr_out + start, stop - start,
+                              channelStream[stripIndex] + start * pixelBytes, first - start);
+    }
+    else
+    {
+        level = convertPixels(stripIndex * num_leds_pr_out + first, min(length / pixelBytes, end - first), data, 0);
+    }
+    universeLevel[slot] = level;
+    outputDirty = true;
+    return true;
+}
+
+// Copy `count` pixels of DMX data to the pixel buffer, returns the sum of
+// the output channels from pixel `sumFrom` on
+uint32_t convertPixels(int pixel, int count, const uint8_t *src, int sumFrom)
+{
+    uint32_t level = 0;
+    for (int i = 0; i < count; i++, src += pixelBytes)
+    {
+        uint8_t c[4];
+        if (pixelWide)
+        {
+            // Ordered dither, shifted every frame so the error averages out over time too
+            uint8_t d = ditherPattern[(pixel + i + ditherPhase) & 7];
+            for (int ch = 0; ch < pixelChannels; ch++)
+            {
+                uint32_t v = (src[ch * 2] << 8 | src[ch * 2 + 1]) + d;
+                c[ch] = v > 0xFFFF ? 255 : v >> 8;
+            }
+        }
+        else
+        {
+            memcpy(c, src, pixelChannels);
+        }
+
+        if (pixelChannels == 4)
+        {
+            leds.setPixel(pixel + i, c[0], c[1], c[2], c[3]);
+            if (i >= sumFrom)
+                level += c[0] + c[1] + c[2] + c[3];
+        }
+        else
+        {
+            leds.setPixel(pixel + i, c[0], c[1], c[2]);
+            if (i >= sumFrom)
+                level += c[0] + c[1] + c[2];
+        }
+    }
+    return level;
 }
 
-void initializeLEDs()
+void presentFrame()
 {
-    // Map ledType and colorOrder to OctoWS2811 configurations
-    int ledConfig = WS2811_800kHz; // Default
-    if (ledType == "WS2811")
+    if (!outputDirty)
     {
-        ledConfig |= WS2811_GRB; // Default color order
+        return;
     }
-    else if (ledType == "WS2812")
+    limitPower();
+    updateLEDs();
+    restorePower();
+    outputDirty = false;
+    ditherPhase++;
+}
+
+// The frame is complete once every live universe of every strip has arrived
+void trackArrival(int slot)
+{
+    int strip = slot / UNIVERSES_BY_OUT;
+    uint16_t bit = 1 << (slot % UNIVERSES_BY_OUT);
+    if (stripArrived[strip] & bit)
     {
-        ledConfig |= WS2811_GRB;
+        // Seen twice before the frame completed, a packet of the last frame was lost
+        memset(stripArrived, 0, sizeof(stripArrived));
     }
-    else if (ledType == "WS2813")
+    stripArrived[strip] |= bit;
+
+    // A universe that was not live does not tell where the frame ends, the
+    // stream is still starting up or coming back
+    if (universeState[slot] != SIGNAL_LIVE)
     {
-        ledConfig |= WS2811_GRB;
+        return;
     }
 
-    // Set color order
-    if (colorOrder == "GRB")
+    for (int s = 0; s < NUM_STRIPS; s++)
     {
-        ledConfig |= WS2811_GRB;
+        uint16_t expected = 0;
+        for (int u = 0; u < UNIVERSES_BY_OUT; u++)
+        {
+            if (universeState[s * UNIVERSES_BY_OUT + u] == SIGNAL_LIVE)
+            {
+                expected |= 1 << u;
+            }
+        }
+        if ((stripArrived[s] & expected) != expected)
+        {
+            return;
+        }
     }
-    else if (colorOrder == "RGB")
+    frameComplete = true;
+}
+
+// Some universe of the next frame has arrived, but not all of them
+bool frameArriving()
+{
+    for (int s = 0; s < NUM_STRIPS; s++)
     {
-        ledConfig |= WS2811_RGB;
+        if (stripArrived[s] != 0)
+        {
+            return true;
+        }
     }
-    else if (colorOrder == "BRG")
+    return false;
+}
+
+// Pixels of its strip a universe owns, those whose first channel it carries
+void universePixelRange(int slot, int *first, int *end)
+{
+    int u = slot % UNIVERSES_BY_OUT;
+    if (pixelPacking)
     {
-        ledConfig |= WS2811_BRG;
+        *first = (u * 512 + pixelBytes - 1) / pixelBytes;
+        *end = min(((u + 1) * 512 + pixelBytes - 1) / pixelBytes, num_leds_pr_out);
+    }
+    else
+    {
+        *first = u * pixelsPerUniverse;
+        *end = min(*first + pixelsPerUniverse, num_leds_pr_out);
+    }
+}
+
+// Raw bytes of the pixel buffer that a routed universe is mapped to
+uint8_t *universePixels(int slot, uint16_t *bytes)
+{
+    int stripIndex = slot / UNIVERSES_BY_OUT;
+    int first, end;
+    universePixelRange(slot, &first, &end);
+    *bytes = (end - first) * pixelChannels;
+    return (uint8_t *)drawingMemory + ((stripIndex * num_leds_pr_out) + first) * pixelChannels;
+}
+
+void checkSignalLoss(unsigned long currentTime)
+{
+    bool anyLive = false;
+    bool anyLost = false;
+    for (int slot = 0; slot < maxUniverses; slot++)
+    {
+        if (universeState[slot] == SIGNAL_LIVE && currentTime - universeLastSeen[slot] >= lossTimeout)
+        {
+            universeState[slot] = SIGNAL_LOST;
+
+            uint16_t bytes;
+            uint8_t *pixels = universePixels(slot, &bytes);
+            if (lossAction == LOSS_FADE)
+            {
+                memcpy(fadeFrom[slot], pixels, bytes);
+                fadeStart[slot] = currentTime;
+                fading[slot] = true;
+            }
+            else if (lossAction == LOSS_BLACKOUT)
+            {
+                memset(pixels, 0, bytes);
+                universeLevel[slot] = 0;
+                outputDirty = true;
+            }
+        }
+        anyLive |= universeState[slot] == SIGNAL_LIVE;
+        anyLost |= universeState[slot] == SIGNAL_LOST;
+    }
+
+    // The SD show takes over the whole node once every universe has gone quiet
+    if (lossAction == LOSS_PLAYBACK && anyLost && !anyLive && !lossPlayback)
+    {
+        lossPlayback = true;
+        if (!showPlayer.isPlaying())
+        {
+            showPlayer.begin(SHOW_FILE, true);
+        }
+    }
+}
+
+void updateFades(unsigned long currentTime)
+{
+    for (int slot = 0; slot < maxUniverses; slot++)
+    {
+        if (!fading[slot])
+        {
+            continue;
+        }
+
+        unsigned long elapsed = currentTime - fadeStart[slot];
+        uint16_t level = elapsed >= fadeTime ? 0 : 256 - (elapsed * 256 / max(fadeTime, (uint16_t)1));
+        uint16_t bytes;
+        uint8_t *pixels = universePixels(slot, &bytes);
+        uint32_t sum = 0;
+        for (uint16_t i = 0; i < bytes; i++)
+        {
+            pixels[i] = (fadeFrom[slot][i] * level) >> 8;
+            sum += pixels[i];
+        }
+        universeLevel[slot] = sum;
+        fading[slot] = level > 0;
+        outputDirty = true;
+    }
+}
+
+// Scale the frame down in place when the estimated current exceeds the
+// per-output or global budget. Levels come from the copy in writeUniverse(),
+// so nothing is touched while the frame is within budget.
+void limitPower()
+{
+    if (outputBudget == 0 && powerBudget == 0)
+    {
+        return;
+    }
+
+    const uint32_t idle = num_leds_pr_out * LED_MA_IDLE;
+    uint32_t stripCurrent[NUM_STRIPS];
+    uint16_t stripScale[NUM_STRIPS];
+    uint32_t total = 0;
+    for (int strip = 0; strip < NUM_STRIPS; strip++)
+    {
+        uint32_t level = 0;
+        for (int u = 0; u < UNIVERSES_BY_OUT; u++)
+        {
+            level += universeLevel[strip * UNIVERSES_BY_OUT + u];
+        }
+        stripCurrent[strip] = level * LED_MA_PER_CHANNEL / 255;
+        stripScale[strip] = 256;
+        if (outputBudget > idle && stripCurrent[strip] + idle > outputBudget)
+        {
+            stripScale[strip] = (outputBudget - idle) * 256 / stripCurrent[strip];
+        }
+        total += (stripCurrent[strip] * stripScale[strip] >> 8) + idle;
+    }
+
+    uint32_t globalScale = 256;
+    uint32_t totalIdle = idle * NUM_STRIPS;
+    if (powerBudget > totalIdle && total > powerBudget)
+    {
+        globalScale = (uint64_t)(powerBudget - totalIdle) * 256 / (total - totalIdle);
+    }
+
+    for (int strip = 0; strip < NUM_STRIPS; strip++)
+    {
+        uint32_t scale = stripScale[strip] * globalScale >> 8;
+        if (scale >= 256)
+        {
+            continue;
+        }
+        for (int u = 0; u < UNIVERSES_BY_OUT; u++)
+        {
+            int slot = strip * UNIVERSES_BY_OUT + u;
+            uint16_t bytes;
+            uint8_t *pixels = universePixels(slot, &bytes);
+            memcpy(limitBackup + (pixels - (uint8_t *)drawingMemory), pixels, bytes);
+            for (uint16_t i = 0; i < bytes; i++)
+            {
+                pixels[i] = (pixels[i] * scale) >> 8;
+            }
+        }
+        stripLimited[strip] = true;
+    }
+}
+
+// show() has copied the scaled frame, put the source pixels back
+void restorePower()
+{
+    for (int strip = 0; strip < NUM_STRIPS; strip++)
+    {
+        if (!stripLimited[strip])
+        {
+            continue;
+        }
+        for (int u = 0; u < UNIVERSES_BY_OUT; u++)
+        {
+            uint16_t bytes;
+            uint8_t *pixels = universePixels(strip * UNIVERSES_BY_OUT + u, &bytes);
+            memcpy(pixels, limitBackup + (pixels - (uint8_t *)drawingMemory), bytes);
+        }
+        stripLimited[strip] = false;
+    }
+}
+
+// Send the forwarded universes received since the last frame, followed by ArtSync
+void forwardFrame()
+{
+    if (artnet.getRouteCount() == 0)
+    {
+        return;
+    }
+    uint32_t flushStart = ARM_DWT_CYCCNT;
+    if (artnet.flush() > 0)
+    {
+        recordTiming(forwardTiming, ARM_DWT_CYCCNT - flushStart);
+    }
+}
+
+// Snapshot the selected universe, or every strip, for the pixel preview
+void updatePreview()
+{
+    uint16_t universe = previewUniverse();
+    int slot = universe - START_UNIVERSE;
+    if (universe != PREVIEW_ALL && slot >= 0 && slot < maxUniverses)
+    {
+        int first, end;
+        universePixelRange(slot, &first, &end);
+        capturePreview(leds, universe, num_leds_pr_out, slot / UNIVERSES_BY_OUT, 1, first, end);
+    }
+    else
+    {
+        capturePreview(leds, PREVIEW_ALL, num_leds_pr_out, 0, NUM_STRIPS, 0, num_leds_pr_out);
+    }
+}
+
+void updateLEDs()
+{
+    // show() first waits for the previous frame to leave the wire. Wait here
+    // instead so showTiming holds only the copy and DMA start, the wire time
+    // is already in the planner's transmit estimate.
+    while (leds.busy())
+    {
+    }
+    netStats.onShow(micros());
+    uint32_t showStart = ARM_DWT_CYCCNT;
+    leds.show();
+    recordTiming(showTiming, ARM_DWT_CYCCNT - showStart);
+}
+
+FLASHMEM void initializeLEDs()
+{
+    // Pixel layout
+    pixelChannels = (pixelFormat == PIXEL_RGBW8 || pixelFormat == PIXEL_RGBW16) ? 4 : 3;
+    pixelWide = pixelFormat == PIXEL_RGB16 || pixelFormat == PIXEL_RGBW16;
+    pixelBytes = pixelChannels * (pixelWide ? 2 : 1);
+    pixelsPerUniverse = 512 / pixelBytes;
+    num_leds_pr_out = pixelPacking ? 512 * UNIVERSES_BY_OUT / pixelBytes : pixelsPerUniverse * UNIVERSES_BY_OUT;
+
+    // Map colorOrder to OctoWS2811 configurations, all supported types run at 800 kHz
+    int ledConfig = WS2811_800kHz;
+    if (strcmp(colorOrder, "RGB") == 0)
+    {
+        ledConfig |= pixelChannels == 4 ? WS2811_RGBW : WS2811_RGB;
+    }
+    else if (strcmp(colorOrder, "BRG") == 0)
+    {
+        ledConfig |= pixelChannels == 4 ? WS2811_BRGW : WS2811_BRG;
+    }
+    else
+    {
+        ledConfig |= pixelChannels == 4 ? WS2811_GRBW : WS2811_GRB;
     }
 
     // Initialize OctoWS2811
@@ -212,7 +690,7 @@ void initializeLEDs()
     leds.show();
 }
 
-void initializeArtNet()
+FLASHMEM void initializeArtNet()
 {
     byte ipBytes[4];
     for (int i = 0; i < 4; i++)
@@ -233,4 +711,20 @@ void initializeArtNet()
 
     // Set the ArtDmx callback
     artnet.setArtDmxCallback(onDmxFrame);
+
+    // Art-Net forwarding to a downstream node
+    if ((uint32_t)forwardIP != 0)
+    {
+        for (int i = 0; i < forwardCount; i++)
+        {
+            if (!artnet.addRoute(forwardFrom + i, forwardIP, forwardTo + i))
+            {
+                Serial.print("Forwarding rejected for universe ");
+                Serial.println(forwardFrom + i);
+            }
+        }
+    }
+
+    // Shared time base for synchronised presentation across nodes
+    timeSync.begin(artnet.getBroadcast(), syncMode);
 }
\ No newline at end of file
@@ -0,0 +1,100 @@
+#include "netstats.h"
+
+NetStats netStats;
+
+NetStats::NetStats()
+{
+  reset();
+}
+
+void NetStats::reset()
+{
+  packets = 0;
+  dropped = 0;
+  reordered = 0;
+  frames = 0;
+  rateStart = 0;
+  ratePackets = 0;
+  packetRate = 0;
+  samples = 0;
+  memset(lastSequence, 0, sizeof(lastSequence));
+  memset(pending, 0, sizeof(pending));
+  memset(histogram, 0, sizeof(histogram));
+}
+
+void NetStats::onPacket(uint8_t slot, uint8_t sequence, uint32_t time)
+{
+  if (slot >= STATS_MAX_UNIVERSES)
+    return;
+
+  packets++;
+  ratePackets++;
+  if (time - rateStart >= 1000000)
+  {
+    packetRate = ratePackets * 1000000ULL / (time - rateStart);
+    ratePackets = 0;
+    rateStart = time;
+  }
+
+  // Sequence 0 means the sender doesn't number its packets
+  uint8_t last = lastSequence[slot];
+  if (sequence != 0 && last != 0)
+  {
+    // 1..255 wrap around, 0 is skipped
+    uint8_t gap = (sequence - last + 255) % 255;
+    if (gap > 127)
+    {
+      // A late packet filling a gap that was counted as a drop, keep
+      // tracking from the newest sequence
+      reordered++;
+      if (dropped > 0)
+        dropped--;
+    }
+    else if (gap > 1)
+    {
+      dropped += gap - 1;
+    }
+    if (gap <= 127)
+      lastSequence[slot] = sequence;
+  }
+  else
+  {
+    lastSequence[slot] = sequence;
+  }
+
+  if (pending[slot] == 0)
+    pending[slot] = time | 1; // Never 0 so it can't be mistaken for "none"
+}
+
+void NetStats::onShow(uint32_t time)
+{
+  frames++;
+  for (uint8_t i = 0; i < STATS_MAX_UNIVERSES; i++)
+  {
+    if (pending[i] == 0)
+      continue;
+
+    // pending is forced odd, a show in the same microsecond would wrap around
+    int32_t latency = max((int32_t)(time - pending[i]), (int32_t)0);
+    uint32_t bucket = latency / STATS_BUCKET_US;
+    histogram[min(bucket, (uint32_t)STATS_BUCKETS - 1)]++;
+    samples++;
+    pending[i] = 0;
+  }
+}
+
+uint32_t NetStats::getLatencyPercentile(uint8_t percent)
+{
+  if (samples == 0)
+    return 0;
+
+  uint32_t target = (uint64_t)samples * percent / 100;
+  uint32_t count = 0;
+  for (uint16_t i = 0; i < STATS_BUCKETS; i++)
+  {
+    count += histogram[i];
+    if (count > target)
+      return (i + 1) * STATS_BUCKET_US; // Upper edge of the bucket
+  }
+  return STATS_BUCKETS * STATS_BUCKET_US;
+}
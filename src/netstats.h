@@ -0,0 +1,70 @@
+#ifndef NETSTATS_H
+#define NETSTATS_H
+
+#include <Arduino.h>
+
+// Ingest statistics for benchmarking the node under load (see
+// tools/artnet_loadgen.cpp): packet rate, sequence gaps and reordering per
+// universe, and packet-to-pixel latency from ArtDmx arrival to the show()
+// that puts it on the strips.
+
+#define STATS_MAX_UNIVERSES 16
+#define STATS_BUCKET_US 250
+#define STATS_BUCKETS 128 // Last bucket collects everything beyond 32 ms
+
+class NetStats
+{
+public:
+  NetStats();
+
+  void reset();
+  void onPacket(uint8_t slot, uint8_t sequence, uint32_t time);
+  void onShow(uint32_t time);
+
+  uint32_t getLatencyPercentile(uint8_t percent);
+
+  inline uint32_t getPackets(void)
+  {
+    return packets;
+  }
+
+  inline uint32_t getPacketRate(void)
+  {
+    return packetRate;
+  }
+
+  inline uint32_t getDropped(void)
+  {
+    return dropped;
+  }
+
+  inline uint32_t getReordered(void)
+  {
+    return reordered;
+  }
+
+  inline uint32_t getFrames(void)
+  {
+    return frames;
+  }
+
+private:
+  uint32_t packets;
+  uint32_t dropped;
+  uint32_t reordered;
+  uint32_t frames;
+
+  uint32_t rateStart;
+  uint32_t ratePackets;
+  uint32_t packetRate;
+
+  uint8_t lastSequence[STATS_MAX_UNIVERSES];
+  uint32_t pending[STATS_MAX_UNIVERSES]; // Arrival of the oldest packet not yet shown, 0 = none
+
+  uint32_t histogram[STATS_BUCKETS];
+  uint32_t samples;
+};
+
+extern NetStats netStats;
+
+#endif // NETSTATS_H
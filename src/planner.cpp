@@ -0,0 +1,58 @@
+#include "planner.h"
+#include "config.h"
+
+timing_stat_s ingestTiming;
+timing_stat_s showTiming;
+timing_stat_s forwardTiming;
+
+static frame_config_s frameConfig;
+
+void setFrameConfig(uint16_t ledsPerOutput, uint8_t outputs, uint8_t channelsPerLed, uint16_t universes)
+{
+  frameConfig.ledsPerOutput = ledsPerOutput;
+  frameConfig.outputs = outputs;
+  frameConfig.channelsPerLed = channelsPerLed;
+  frameConfig.universes = universes;
+}
+
+frame_plan_s planFrame(const frame_config_s &config, uint32_t ingestCycles, uint32_t setupCycles, uint16_t targetFps)
+{
+  frame_plan_s plan;
+  uint32_t bits = (uint32_t)config.ledsPerOutput * config.channelsPerLed * 8;
+  plan.transmitUs = bits * WS2811_BIT_NS / 1000;
+  plan.latchUs = WS2811_LATCH_US;
+  if (setupCycles == 0)
+    setupCycles = WS2811_DMA_SETUP_US * (F_CPU_ACTUAL / 1000000);
+  plan.setupUs = cyclesToMicros(setupCycles);
+  plan.ingestUs = cyclesToMicros(ingestCycles);
+  plan.outputUs = plan.transmitUs + plan.latchUs;
+  // Summed in cycles, ingest costs of a few us would lose up to a third
+  // of each universe to truncation otherwise
+  plan.cpuUs = cyclesToMicros(config.universes * ingestCycles + setupCycles);
+
+  // DMA shifts the previous frame out while the CPU ingests the next one
+  uint32_t frameUs = max(plan.outputUs, plan.cpuUs);
+  plan.maxFps = frameUs ? 1000000 / frameUs : 0;
+
+  uint32_t targetUs = 1000000 / max(targetFps, (uint16_t)1);
+  plan.headroom = ((int32_t)targetUs - (int32_t)frameUs) * 100 / (int32_t)targetUs;
+  return plan;
+}
+
+frame_plan_s currentFramePlan()
+{
+  return planFrame(frameConfig, ingestTiming.avg, showTiming.avg, updateSpeed);
+}
+
+void recordTiming(timing_stat_s &stat, uint32_t cycles)
+{
+  stat.last = cycles;
+  stat.avg = stat.count ? stat.avg - (stat.avg >> 4) + (cycles >> 4) : cycles;
+  stat.max = max(stat.max, cycles);
+  stat.count++;
+}
+
+uint32_t cyclesToMicros(uint32_t cycles)
+{
+  return cycles / (F_CPU_ACTUAL / 1000000);
+}
@@ -0,0 +1,50 @@
+#ifndef PLANNER_H
+#define PLANNER_H
+
+#include <Arduino.h>
+
+// Frame budget model. Output time is what the WS281x protocol needs on the
+// wire (all outputs shift out in parallel), CPU time is the measured cost of
+// ingesting every universe once plus the show() call. Whichever is larger
+// bounds the achievable refresh rate.
+
+#define WS2811_BIT_NS 1250 // 800 kHz
+#define WS2811_LATCH_US 300 // Reset time OctoWS2811 leaves between frames
+#define WS2811_DMA_SETUP_US 10 // Estimate until show() has been measured
+
+struct timing_stat_s {
+  uint32_t last;  // cycles
+  uint32_t avg;   // cycles, exponential average
+  uint32_t max;   // cycles
+  uint32_t count;
+};
+
+struct frame_config_s {
+  uint16_t ledsPerOutput;
+  uint8_t  outputs;
+  uint8_t  channelsPerLed;
+  uint16_t universes;
+};
+
+struct frame_plan_s {
+  uint32_t transmitUs; // Pixel data on the wire
+  uint32_t latchUs;
+  uint32_t setupUs;    // show() call: buffer copy and DMA setup
+  uint32_t ingestUs;   // One universe through artnet.read() and onDmxFrame
+  uint32_t outputUs;   // transmit + latch
+  uint32_t cpuUs;      // ingest of every universe + setup
+  uint16_t maxFps;
+  int16_t  headroom;   // % of the frame left at the configured update speed
+};
+
+extern timing_stat_s ingestTiming;
+extern timing_stat_s showTiming;
+extern timing_stat_s forwardTiming;
+
+void setFrameConfig(uint16_t ledsPerOutput, uint8_t outputs, uint8_t channelsPerLed, uint16_t universes);
+frame_plan_s planFrame(const frame_config_s &config, uint32_t ingestCycles, uint32_t setupCycles, uint16_t targetFps);
+frame_plan_s currentFramePlan();
+void recordTiming(timing_stat_s &stat, uint32_t cycles);
+uint32_t cyclesToMicros(uint32_t cycles);
+
+#endif // PLANNER_H
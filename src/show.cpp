@@ -0,0 +1,492 @@
+#include "show.h"
+
+// Only touched while recording or playing, keep them out of DTCM
+DMAMEM ShowRecorder showRecorder;
+DMAMEM ShowPlayer showPlayer;
+
+// --------------------------------------------------------------------------
+//  Recorder
+// --------------------------------------------------------------------------
+ShowRecorder::ShowRecorder() : recording(false), overruns(0) {}
+
+FLASHMEM bool ShowRecorder::begin(const char *path)
+{
+  if (recording)
+    end();
+
+  SD.remove(path);
+  file = SD.open(path, FILE_WRITE);
+  if (!file)
+  {
+    Serial.println("Failed to open show file for recording.");
+    return false;
+  }
+
+  // Placeholder header, patched with the index location in end()
+  show_header_s header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, SHOW_MAGIC, sizeof(header.magic));
+  header.version = SHOW_VERSION;
+  file.write((uint8_t *)&header, sizeof(header));
+
+  fileOffset = sizeof(header);
+  bufferFill[0] = 0;
+  bufferFill[1] = 0;
+  active = 0;
+  pending = false;
+  slotCount = 0;
+  keyframes = 0;
+  indexCount = 0;
+  indexStride = 1;
+  overruns = 0;
+  startTime = millis();
+  lastKeyframe = 0;
+  recording = true;
+
+  writeKeyframe(0);
+
+  Serial.print("Recording show to ");
+  Serial.println(path);
+  return true;
+}
+
+FLASHMEM void ShowRecorder::end()
+{
+  if (!recording)
+    return;
+  recording = false;
+
+  flushPending();
+  file.write(buffer[active], bufferFill[active]);
+  bufferFill[active] = 0;
+
+  file.write((uint8_t *)index, indexCount * sizeof(show_index_s));
+
+  show_header_s header;
+  memcpy(header.magic, SHOW_MAGIC, sizeof(header.magic));
+  header.version = SHOW_VERSION;
+  header.indexCount = indexCount;
+  header.indexOffset = fileOffset;
+  header.duration = millis() - startTime;
+  file.seek(0);
+  file.write((uint8_t *)&header, sizeof(header));
+  file.close();
+
+  Serial.print("Show recording stopped, overruns: ");
+  Serial.println(overruns);
+}
+
+void ShowRecorder::capture(uint16_t universe, uint16_t length, const uint8_t *data)
+{
+  if (!recording)
+    return;
+
+  int8_t slot = findSlot(universe);
+  if (slot < 0)
+    return;
+
+  uint32_t time = millis() - startTime;
+  if (time - lastKeyframe >= SHOW_KEYFRAME_INTERVAL)
+  {
+    writeKeyframe(time);
+  }
+
+  length = min(length, (uint16_t)SHOW_UNIVERSE_SIZE);
+
+  bool written;
+  if (previousLength[slot] != length)
+  {
+    written = writeRecord(SHOW_REC_KEY, universe, time, data, length);
+  }
+  else
+  {
+    uint16_t deltaLength = encodeDelta(previous[slot], data, length);
+    if (deltaLength == 0)
+      return; // Nothing changed
+    if (deltaLength < length)
+      written = writeRecord(SHOW_REC_DELTA, universe, time, delta, deltaLength);
+    else
+      written = writeRecord(SHOW_REC_KEY, universe, time, data, length);
+  }
+
+  if (written)
+  {
+    memcpy(previous[slot], data, length);
+    previousLength[slot] = length;
+  }
+  else
+  {
+    // The file no longer matches `previous`, force a keyframe next time
+    previousLength[slot] = 0;
+  }
+}
+
+void ShowRecorder::service()
+{
+  if (recording)
+    flushPending();
+}
+
+bool ShowRecorder::writeRecord(uint8_t type, uint16_t universe, uint32_t time, const uint8_t *payload, uint16_t length)
+{
+  uint16_t size = sizeof(show_record_s) + length;
+  uint16_t available = (SHOW_BUFFER_SIZE - bufferFill[active]) + (pending ? 0 : SHOW_BUFFER_SIZE);
+  if (size > available)
+  {
+    overruns++;
+    return false;
+  }
+
+  show_record_s record;
+  record.type = type;
+  record.reserved = 0;
+  record.universe = universe;
+  record.time = time;
+  record.length = length;
+  append(&record, sizeof(record));
+  append(payload, length);
+  return true;
+}
+
+void ShowRecorder::writeKeyframe(uint32_t time)
+{
+  uint32_t offset = fileOffset;
+  if (!writeRecord(SHOW_REC_SYNC, 0, time, NULL, 0))
+    return;
+  lastKeyframe = time;
+
+  for (uint8_t i = 0; i < slotCount; i++)
+  {
+    if (previousLength[i] == 0)
+      continue;
+    if (!writeRecord(SHOW_REC_KEY, slotUniverse[i], time, previous[i], previousLength[i]))
+      previousLength[i] = 0;
+  }
+
+  // Thin the index out when it fills up so long recordings stay seekable
+  if (keyframes++ % indexStride != 0)
+    return;
+  if (indexCount == SHOW_INDEX_SIZE)
+  {
+    for (uint16_t i = 0; i < SHOW_INDEX_SIZE / 2; i++)
+      index[i] = index[i * 2];
+    indexCount = SHOW_INDEX_SIZE / 2;
+    indexStride *= 2;
+  }
+  index[indexCount].time = time;
+  index[indexCount].offset = offset;
+  indexCount++;
+}
+
+uint16_t ShowRecorder::encodeDelta(const uint8_t *prev, const uint8_t *data, uint16_t length)
+{
+  uint16_t out = 0;
+  uint16_t i = 0;
+  while (i < length)
+  {
+    if (data[i] == prev[i])
+    {
+      i++;
+      continue;
+    }
+
+    // Extend the run across gaps that are cheaper to copy than a new run header
+    uint16_t start = i;
+    uint16_t last = i;
+    for (uint16_t j = i + 1; j < length && j - last <= (int)sizeof(show_run_s); j++)
+    {
+      if (data[j] != prev[j])
+        last = j;
+    }
+
+    show_run_s run;
+    run.offset = start;
+    run.count = last - start + 1;
+    if (out + sizeof(run) + run.count >= length)
+      return length;
+
+    memcpy(delta + out, &run, sizeof(run));
+    memcpy(delta + out + sizeof(run), data + start, run.count);
+    out += sizeof(run) + run.count;
+    i = last + 1;
+  }
+  return out;
+}
+
+bool ShowRecorder::append(const void *data, uint16_t length)
+{
+  const uint8_t *src = (const uint8_t *)data;
+  while (length > 0)
+  {
+    uint16_t room = SHOW_BUFFER_SIZE - bufferFill[active];
+    if (room == 0)
+    {
+      if (pending)
+        return false;
+      pending = true;
+      active ^= 1;
+      bufferFill[active] = 0;
+      continue;
+    }
+    uint16_t n = min(room, length);
+    memcpy(buffer[active] + bufferFill[active], src, n);
+    bufferFill[active] += n;
+    fileOffset += n;
+    src += n;
+    length -= n;
+  }
+  return true;
+}
+
+int8_t ShowRecorder::findSlot(uint16_t universe)
+{
+  for (uint8_t i = 0; i < slotCount; i++)
+  {
+    if (slotUniverse[i] == universe)
+      return i;
+  }
+  if (slotCount == SHOW_MAX_UNIVERSES)
+    return -1;
+
+  slotUniverse[slotCount] = universe;
+  previousLength[slotCount] = 0;
+  return slotCount++;
+}
+
+void ShowRecorder::flushPending()
+{
+  if (!pending)
+    return;
+  file.write(buffer[active ^ 1], SHOW_BUFFER_SIZE);
+  pending = false;
+}
+
+// --------------------------------------------------------------------------
+//  Player
+// --------------------------------------------------------------------------
+ShowPlayer::ShowPlayer() : playing(false), frameCallback(NULL) {}
+
+FLASHMEM bool ShowPlayer::begin(const char *path, bool loop)
+{
+  if (playing)
+    end();
+
+  file = SD.open(path);
+  if (!file)
+  {
+    Serial.println("No show file found on SD card.");
+    return false;
+  }
+
+  if (file.read(&header, sizeof(header)) != sizeof(header) ||
+      memcmp(header.magic, SHOW_MAGIC, sizeof(header.magic)) != 0 ||
+      header.version != SHOW_VERSION)
+  {
+    Serial.println("Invalid show file.");
+    file.close();
+    return false;
+  }
+
+  dataStart = sizeof(header);
+  dataEnd = file.size();
+  if (header.indexOffset != 0)
+  {
+    // Recordings that were cut short have no index and play to the end of the file
+    dataEnd = header.indexOffset;
+    header.indexCount = min(header.indexCount, (uint16_t)SHOW_INDEX_SIZE);
+    file.seek(header.indexOffset);
+    file.read(index, header.indexCount * sizeof(show_index_s));
+  }
+  else
+  {
+    header.indexCount = 0;
+  }
+
+  slotCount = 0;
+  looping = loop;
+  playing = true;
+  seek(0);
+
+  Serial.print("Playing show from ");
+  Serial.println(path);
+  return true;
+}
+
+FLASHMEM void ShowPlayer::end()
+{
+  if (!playing)
+    return;
+  playing = false;
+  file.close();
+  Serial.println("Show playback stopped.");
+}
+
+bool ShowPlayer::seek(uint32_t time)
+{
+  if (!playing)
+    return false;
+
+  uint32_t offset = dataStart;
+  for (uint16_t i = 0; i < header.indexCount && index[i].time <= time; i++)
+  {
+    offset = index[i].offset;
+  }
+
+  if (!file.seek(offset))
+    return false;
+  readOffset = offset;
+  head = 0;
+  fillCount = 0;
+  eof = false;
+  startTime = millis();
+  timeOffset = time;
+  lastTime = time;
+
+  fill();
+  return true;
+}
+
+void ShowPlayer::service()
+{
+  if (!playing)
+    return;
+
+  fill();
+
+  uint32_t elapsed = millis() - startTime + timeOffset;
+  show_record_s rec;
+  for (uint8_t n = 0; n < SHOW_MAX_RECORDS_PER_SERVICE; n++)
+  {
+    if (!peek(record, sizeof(rec)))
+      break;
+    memcpy(&rec, record, sizeof(rec));
+    if (rec.length > SHOW_UNIVERSE_SIZE)
+    {
+      Serial.println("Corrupt show record, stopping playback.");
+      end();
+      return;
+    }
+    if (rec.time > elapsed)
+      return;
+
+    uint16_t size = sizeof(rec) + rec.length;
+    if (!peek(record, size))
+      break;
+    consume(size);
+    lastTime = rec.time;
+    apply(rec, record + sizeof(rec));
+  }
+
+  if (!eof)
+    return;
+
+  // Anything left that isn't a whole record is a truncated tail
+  bool more = peek(record, sizeof(rec));
+  if (more)
+  {
+    memcpy(&rec, record, sizeof(rec));
+    more = peek(record, sizeof(rec) + rec.length);
+  }
+  if (!more)
+  {
+    // Hold the last frame until the recording ends. A recording that was
+    // cut short has no duration, give its last frame one keyframe interval.
+    uint32_t duration = header.indexOffset != 0 ? header.duration : lastTime + SHOW_KEYFRAME_INTERVAL;
+    if (elapsed < duration)
+      return;
+    if (looping)
+      seek(0);
+    else
+      end();
+  }
+}
+
+void ShowPlayer::fill()
+{
+  // Only whole halves are refilled, so a single SD read happens per call
+  if (eof || fillCount > SHOW_BUFFER_SIZE)
+    return;
+
+  uint16_t writePos = (head + fillCount) % sizeof(buffer);
+  uint16_t toRead = min((uint32_t)SHOW_BUFFER_SIZE, dataEnd - readOffset);
+  int n = toRead > 0 ? file.read(buffer + writePos, toRead) : 0;
+  if (n <= 0)
+  {
+    eof = true;
+    return;
+  }
+  readOffset += n;
+  fillCount += n;
+  if (n < SHOW_BUFFER_SIZE || readOffset >= dataEnd)
+    eof = true;
+}
+
+bool ShowPlayer::peek(uint8_t *dest, uint16_t length)
+{
+  if (fillCount < length)
+    return false;
+
+  uint16_t first = min(length, (uint16_t)(sizeof(buffer) - head));
+  memcpy(dest, buffer + head, first);
+  memcpy(dest + first, buffer, length - first);
+  return true;
+}
+
+void ShowPlayer::consume(uint16_t length)
+{
+  head = (head + length) % sizeof(buffer);
+  fillCount -= length;
+}
+
+void ShowPlayer::apply(const show_record_s &rec, const uint8_t *payload)
+{
+  if (rec.type == SHOW_REC_SYNC)
+    return;
+
+  int8_t slot = findSlot(rec.universe);
+  if (slot < 0)
+    return;
+
+  if (rec.type == SHOW_REC_KEY)
+  {
+    memcpy(universes[slot], payload, rec.length);
+    universeLength[slot] = rec.length;
+  }
+  else if (rec.type == SHOW_REC_DELTA)
+  {
+    uint16_t pos = 0;
+    while (pos + sizeof(show_run_s) <= rec.length)
+    {
+      show_run_s run;
+      memcpy(&run, payload + pos, sizeof(run));
+      pos += sizeof(run);
+      // A delta without its keyframe (e.g. right after a seek) is skipped
+      if (run.offset + run.count > universeLength[slot] || pos + run.count > rec.length)
+        return;
+      memcpy(universes[slot] + run.offset, payload + pos, run.count);
+      pos += run.count;
+    }
+  }
+  else
+  {
+    return;
+  }
+
+  if (frameCallback && universeLength[slot] > 0)
+    (*frameCallback)(rec.universe, universeLength[slot], universes[slot]);
+}
+
+int8_t ShowPlayer::findSlot(uint16_t universe)
+{
+  for (uint8_t i = 0; i < slotCount; i++)
+  {
+    if (slotUniverse[i] == universe)
+      return i;
+  }
+  if (slotCount == SHOW_MAX_UNIVERSES)
+    return -1;
+
+  slotUniverse[slotCount] = universe;
+  universeLength[slotCount] = 0;
+  return slotCount++;
+}
@@ -0,0 +1,176 @@
+#ifndef SHOW_H
+#define SHOW_H
+
+#include <Arduino.h>
+#include <SD.h>
+
+// Show file layout:
+//   show_header_s
+//   records (show_record_s followed by `length` bytes of payload)
+//   index (indexCount x show_index_s), written when recording stops
+//
+// Every SHOW_KEYFRAME_INTERVAL ms the recorder writes a SYNC record followed
+// by a full keyframe of every universe seen so far; all other records are
+// deltas against the previous frame of the same universe. The index points
+// at the SYNC records so the player can seek without decoding the whole file.
+// Universes are stored by number, so a file does not depend on the routing.
+
+#define SHOW_FILE "show.lns"
+#define SHOW_MAGIC "LNSHOW\0\0"
+#define SHOW_VERSION 1
+#define SHOW_MAX_UNIVERSES 16
+#define SHOW_UNIVERSE_SIZE 512
+#define SHOW_BUFFER_SIZE 4096 // Per half of the double buffer
+#define SHOW_INDEX_SIZE 512
+#define SHOW_KEYFRAME_INTERVAL 1000 // ms
+#define SHOW_MAX_RECORDS_PER_SERVICE 32
+// Record types
+#define SHOW_REC_KEY 0x01
+#define SHOW_REC_DELTA 0x02
+#define SHOW_REC_SYNC 0x03
+
+struct show_header_s {
+  uint8_t  magic[8];
+  uint16_t version;
+  uint16_t indexCount;
+  uint32_t indexOffset;
+  uint32_t duration;
+} __attribute__((packed));
+
+struct show_record_s {
+  uint8_t  type;
+  uint8_t  reserved;
+  uint16_t universe;
+  uint32_t time;
+  uint16_t length;
+} __attribute__((packed));
+
+struct show_index_s {
+  uint32_t time;
+  uint32_t offset;
+} __attribute__((packed));
+
+// Delta payloads are a list of runs: show_run_s followed by `count` bytes
+struct show_run_s {
+  uint16_t offset;
+  uint16_t count;
+} __attribute__((packed));
+
+#define SHOW_MAX_RECORD (sizeof(show_record_s) + SHOW_UNIVERSE_SIZE)
+
+class ShowRecorder
+{
+public:
+  ShowRecorder();
+
+  bool begin(const char *path);
+  void end();
+  void capture(uint16_t universe, uint16_t length, const uint8_t *data);
+  void service();
+
+  inline bool isRecording(void)
+  {
+    return recording;
+  }
+
+  inline uint32_t getOverruns(void)
+  {
+    return overruns;
+  }
+
+private:
+  bool writeRecord(uint8_t type, uint16_t universe, uint32_t time, const uint8_t *payload, uint16_t length);
+  void writeKeyframe(uint32_t time);
+  uint16_t encodeDelta(const uint8_t *prev, const uint8_t *data, uint16_t length);
+  bool append(const void *data, uint16_t length);
+  int8_t findSlot(uint16_t universe);
+  void flushPending();
+
+  File file;
+  bool recording;
+  uint32_t startTime;
+  uint32_t lastKeyframe;
+  uint32_t keyframes;
+  uint32_t fileOffset;
+  uint32_t overruns;
+
+  // Double buffered writes: capture() fills `active` while service() writes the other half
+  uint8_t buffer[2][SHOW_BUFFER_SIZE];
+  uint16_t bufferFill[2];
+  uint8_t active;
+  bool pending;
+
+  uint16_t slotUniverse[SHOW_MAX_UNIVERSES];
+  uint8_t slotCount;
+  uint8_t previous[SHOW_MAX_UNIVERSES][SHOW_UNIVERSE_SIZE];
+  uint16_t previousLength[SHOW_MAX_UNIVERSES];
+  uint8_t delta[SHOW_UNIVERSE_SIZE];
+
+  show_index_s index[SHOW_INDEX_SIZE];
+  uint16_t indexCount;
+  uint16_t indexStride;
+};
+
+class ShowPlayer
+{
+public:
+  ShowPlayer();
+
+  bool begin(const char *path, bool loop);
+  void end();
+  bool seek(uint32_t time);
+  void service();
+
+  inline bool isPlaying(void)
+  {
+    return playing;
+  }
+
+  inline uint32_t getDuration(void)
+  {
+    return header.duration;
+  }
+
+  inline void setFrameCallback(void (*fptr)(uint16_t universe, uint16_t length, uint8_t *data))
+  {
+    frameCallback = fptr;
+  }
+
+private:
+  void fill();
+  bool peek(uint8_t *dest, uint16_t length);
+  void consume(uint16_t length);
+  void apply(const show_record_s &record, const uint8_t *payload);
+  int8_t findSlot(uint16_t universe);
+
+  File file;
+  bool playing;
+  bool looping;
+  show_header_s header;
+  uint32_t dataStart;
+  uint32_t dataEnd;
+  uint32_t readOffset;
+  uint32_t startTime;
+  uint32_t timeOffset;
+  uint32_t lastTime; // Time of the last record played
+
+  // Double buffered reads: service() refills one half while the other is being parsed
+  uint8_t buffer[2 * SHOW_BUFFER_SIZE];
+  uint16_t head;
+  uint16_t fillCount;
+  bool eof;
+
+  uint8_t record[SHOW_MAX_RECORD];
+  uint16_t slotUniverse[SHOW_MAX_UNIVERSES];
+  uint8_t slotCount;
+  uint8_t universes[SHOW_MAX_UNIVERSES][SHOW_UNIVERSE_SIZE];
+  uint16_t universeLength[SHOW_MAX_UNIVERSES];
+
+  show_index_s index[SHOW_INDEX_SIZE];
+  void (*frameCallback)(uint16_t universe, uint16_t length, uint8_t *data);
+};
+
+extern ShowRecorder showRecorder;
+extern ShowPlayer showPlayer;
+
+#endif // SHOW_H
@@ -0,0 +1,183 @@
+#include "timesync.h"
+
+TimeSync timeSync;
+
+TimeSync::TimeSync() : mode(TIMESYNC_OFF), synced(false), offset(0), anchor(0), drift(0), delay(0), jitter(0), nodeCount(0) {}
+
+FLASHMEM void TimeSync::begin(IPAddress bc, uint8_t m)
+{
+  broadcast = bc;
+  mode = m;
+  sequence = 0;
+  synced = false;
+  offset = 0;
+  anchor = 0;
+  drift = 0;
+  delay = 0;
+  jitter = 0;
+  nodeCount = 0;
+  lastSync = millis() - TIMESYNC_INTERVAL;
+
+  if (mode == TIMESYNC_OFF)
+    udp.stop();
+  else
+    udp.begin(TIMESYNC_PORT);
+}
+
+void TimeSync::service()
+{
+  if (mode == TIMESYNC_OFF)
+    return;
+
+  int size;
+  while ((size = udp.parsePacket()) > 0)
+  {
+    udp.read(buffer, sizeof(buffer));
+    onPacket(buffer, size, udp.remoteIP());
+  }
+
+  if (mode != TIMESYNC_MASTER || millis() - lastSync < TIMESYNC_INTERVAL)
+    return;
+
+  lastSync = millis();
+  sequence++;
+  send(broadcast, TIMESYNC_SYNC, sequence, micros(), 0);
+}
+
+void TimeSync::onPacket(uint8_t *data, uint16_t length, IPAddress remoteIP)
+{
+  // Stamp first, everything below only adds error
+  uint32_t received = micros();
+
+  timesync_packet_s packet;
+  if (length != sizeof(packet))
+    return;
+  memcpy(&packet, data, sizeof(packet));
+  if (memcmp(packet.magic, TIMESYNC_MAGIC, sizeof(packet.magic)) != 0)
+    return;
+
+  if (mode == TIMESYNC_MASTER)
+  {
+    if (packet.type != TIMESYNC_DELAY_REQ)
+      return;
+    send(remoteIP, TIMESYNC_DELAY_RESP, packet.sequence, packet.t1, received);
+    updateNode(remoteIP, packet, received);
+    return;
+  }
+
+  if (packet.type == TIMESYNC_SYNC)
+  {
+    master = remoteIP;
+    sequence = packet.sequence;
+    syncSent = packet.t1;
+    syncReceived = received;
+    send(master, TIMESYNC_DELAY_REQ, sequence, micros(), 0);
+  }
+  else if (packet.type == TIMESYNC_DELAY_RESP && packet.sequence == sequence && remoteIP == master)
+  {
+    int32_t toSlave = syncReceived - syncSent; // t2 - t1
+    int32_t toMaster = packet.t2 - packet.t1;  // t4 - t3
+    int32_t sampleOffset = (toSlave - toMaster) / 2;
+    uint32_t sampleDelay = (toSlave + toMaster) / 2;
+
+    if (!synced)
+    {
+      offset = sampleOffset;
+      anchor = syncReceived;
+      drift = 0;
+      delay = sampleDelay;
+      jitter = 0;
+      synced = true;
+    }
+    else
+    {
+      // Samples that sat in a queue on the way are not worth using
+      if (sampleDelay > delay * 2 + 200)
+      {
+        delay += (int32_t)(sampleDelay - delay) / 8;
+        return;
+      }
+      // Correct the offset and, more gently, the drift that predicted it
+      int32_t elapsed = syncReceived - anchor;
+      int32_t error = sampleOffset - offsetAt(syncReceived);
+      offset = offsetAt(syncReceived) + error / 8;
+      anchor = syncReceived;
+      if (elapsed > 0)
+        drift += (int64_t)error * 1000000000 / elapsed / 32;
+      delay += (int32_t)(sampleDelay - delay) / 8;
+      jitter += ((int32_t)abs(error) - (int32_t)jitter) / 8;
+    }
+    lastSync = millis();
+  }
+}
+
+void TimeSync::send(IPAddress ip, uint8_t type, uint8_t seq, uint32_t t1, uint32_t t2)
+{
+  timesync_packet_s packet;
+  memcpy(packet.magic, TIMESYNC_MAGIC, sizeof(packet.magic));
+  packet.type = type;
+  packet.sequence = seq;
+  packet.synced = synced;
+  packet.reserved = 0;
+  packet.t1 = t1;
+  packet.t2 = t2;
+  packet.offset = offsetAt(t1);
+  packet.delay = delay;
+  udp.send(ip, TIMESYNC_PORT, (uint8_t *)&packet, sizeof(packet));
+}
+
+void TimeSync::updateNode(IPAddress ip, const timesync_packet_s &packet, uint32_t received)
+{
+  uint8_t i = 0;
+  while (i < nodeCount && nodes[i].ip != ip)
+    i++;
+
+  if (i == nodeCount)
+  {
+    if (nodeCount == TIMESYNC_MAX_NODES)
+    {
+      // Reuse the slot of the node that has been quiet the longest
+      i = 0;
+      for (uint8_t j = 1; j < nodeCount; j++)
+      {
+        if (nodes[j].lastSeen < nodes[i].lastSeen)
+          i = j;
+      }
+    }
+    else
+    {
+      nodeCount++;
+    }
+    nodes[i].ip = ip;
+    nodes[i].synced = false;
+  }
+
+  // t3 on the slave's shared clock plus the path delay is when the request
+  // should have arrived by this clock; the difference is the slave's error
+  int32_t error = (int32_t)(packet.t1 - packet.offset + packet.delay - received);
+  if (!packet.synced)
+    nodes[i].error = 0;
+  else if (!nodes[i].synced)
+    nodes[i].error = error;
+  else
+    nodes[i].error += (error - nodes[i].error) / 8;
+
+  nodes[i].offset = packet.offset;
+  nodes[i].synced = packet.synced;
+  nodes[i].lastSeen = millis();
+}
+
+uint32_t TimeSync::getSkew()
+{
+  // The master is the reference, error 0
+  int32_t low = 0;
+  int32_t high = 0;
+  for (uint8_t i = 0; i < nodeCount; i++)
+  {
+    if (!isLive(nodes[i]))
+      continue;
+    low = min(low, nodes[i].error);
+    high = max(high, nodes[i].error);
+  }
+  return high - low;
+}
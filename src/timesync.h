@@ -0,0 +1,158 @@
+#ifndef TIMESYNC_H
+#define TIMESYNC_H
+
+#include <Arduino.h>
+#include <QNEthernet.h>
+
+using namespace qindesign::network;
+
+// A small PTP-like exchange on its own UDP port. The SYNC packets are
+// broadcast, and Art-Net has no opcode for a private payload like this one,
+// so keeping them off the Art-Net port means other devices never see them.
+//
+// The master broadcasts SYNC with its send time (t1); each slave stamps the
+// arrival (t2), answers with DELAY_REQ (t3) and the master replies with
+// DELAY_RESP carrying its receive time (t4). From those four stamps the slave
+// derives its clock offset and the path delay, and frames are presented on a
+// grid of master time so all nodes show() together. Crystals differ by tens
+// of ppm, so the slave also tracks how fast the offset drifts and
+// extrapolates it between SYNCs.
+//
+// DELAY_REQ also carries the slave's offset and delay, so the master can
+// tell where t3 falls on the shared time base and measure how far each
+// slave is from its own clock. The spread of those errors is the skew
+// between nodes.
+
+#define TIMESYNC_OFF 0
+#define TIMESYNC_MASTER 1
+#define TIMESYNC_SLAVE 2
+
+#define TIMESYNC_PORT 6456
+#define TIMESYNC_INTERVAL 1000 // ms between SYNC broadcasts
+#define TIMESYNC_TIMEOUT 5000 // ms without SYNC before a slave falls back to its own clock
+#define TIMESYNC_MAX_NODES 32
+#define TIMESYNC_MAGIC "LNTS"
+// Packet types
+#define TIMESYNC_SYNC 1
+#define TIMESYNC_DELAY_REQ 2
+#define TIMESYNC_DELAY_RESP 3
+
+struct timesync_packet_s {
+  uint8_t  magic[4];
+  uint8_t  type;
+  uint8_t  sequence;
+  uint8_t  synced; // DELAY_REQ: slave has an offset estimate
+  uint8_t  reserved;
+  uint32_t t1;     // SYNC: master send time, DELAY_REQ/RESP: slave send time
+  uint32_t t2;     // DELAY_RESP: master receive time
+  int32_t  offset; // DELAY_REQ: slave's current offset estimate
+  uint32_t delay;  // DELAY_REQ: slave's current path delay estimate
+} __attribute__((packed));
+
+struct timesync_node_s {
+  IPAddress ip;
+  int32_t offset;   // Slave's local clock - master clock, us
+  int32_t error;    // Slave's shared time - master time, us
+  bool synced;
+  uint32_t lastSeen;
+};
+
+class TimeSync
+{
+public:
+  TimeSync();
+
+  void begin(IPAddress broadcast, uint8_t mode);
+  void service();
+
+  // Microseconds on the shared time base
+  inline uint32_t now(void)
+  {
+    uint32_t time = micros();
+    return time - offsetAt(time);
+  }
+
+  inline bool isSynced(void)
+  {
+    return mode == TIMESYNC_MASTER || (mode == TIMESYNC_SLAVE && synced && millis() - lastSync < TIMESYNC_TIMEOUT);
+  }
+
+  inline uint8_t getMode(void)
+  {
+    return mode;
+  }
+
+  inline int32_t getOffset(void)
+  {
+    return offsetAt(micros());
+  }
+
+  inline int32_t getDrift(void)
+  {
+    return drift;
+  }
+
+  inline uint32_t getDelay(void)
+  {
+    return delay;
+  }
+
+  inline uint32_t getJitter(void)
+  {
+    return jitter;
+  }
+
+  // Master: spread of presentation error across itself and the live slaves, us
+  uint32_t getSkew(void);
+
+  inline uint8_t getNodeCount(void)
+  {
+    return nodeCount;
+  }
+
+  inline const timesync_node_s &getNode(uint8_t i)
+  {
+    return nodes[i];
+  }
+
+  inline bool isLive(const timesync_node_s &node)
+  {
+    return node.synced && millis() - node.lastSeen < TIMESYNC_TIMEOUT;
+  }
+
+private:
+  inline int32_t offsetAt(uint32_t time)
+  {
+    return offset + (int32_t)((int64_t)drift * (int32_t)(time - anchor) / 1000000000);
+  }
+
+  void onPacket(uint8_t *data, uint16_t length, IPAddress remoteIP);
+  void send(IPAddress ip, uint8_t type, uint8_t seq, uint32_t t1, uint32_t t2);
+  void updateNode(IPAddress ip, const timesync_packet_s &packet, uint32_t received);
+
+  EthernetUDP udp;
+  uint8_t buffer[sizeof(timesync_packet_s)];
+  IPAddress broadcast;
+  uint8_t mode;
+  uint8_t sequence;
+  uint32_t lastSync;
+
+  // Slave state
+  bool synced;
+  IPAddress master;
+  uint32_t syncSent;     // t1
+  uint32_t syncReceived; // t2
+  int32_t offset;        // local - master at anchor, us
+  uint32_t anchor;       // local time of the last offset update
+  int32_t drift;         // change of offset, ns per s
+  uint32_t delay;        // one-way path delay, us
+  uint32_t jitter;       // mean deviation of offset samples, us
+
+  // Master state: last report of every slave
+  timesync_node_s nodes[TIMESYNC_MAX_NODES];
+  uint8_t nodeCount;
+};
+
+extern TimeSync timeSync;
+
+#endif // TIMESYNC_H
@@ -0,0 +1,174 @@
+// Host stand-in for the Teensy core, enough for the firmware sources to build
+// and run in the native test environment. Time comes from the host clock or,
+// for simulations, from host::manualMicros.
+
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <algorithm>
+#include <chrono>
+#include <cctype>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <type_traits>
+
+using std::max;
+using std::min;
+
+typedef uint8_t byte;
+
+#define DMAMEM
+#define FLASHMEM
+#define PROGMEM
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define DEC 10
+#define HEX 16
+
+namespace host {
+
+inline bool manualClock = false;
+inline uint64_t manualMicros = 0;
+inline int64_t clockOffset = 0; // Offset of the node currently being run, for multi-node simulations
+inline uint32_t scbAircr = 0;
+
+inline uint64_t realNanos()
+{
+  static const auto start = std::chrono::steady_clock::now();
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+inline uint64_t nowMicros()
+{
+  return (manualClock ? manualMicros : realNanos() / 1000) + clockOffset;
+}
+
+// Cycles of a 600 MHz core
+inline uint32_t cycles()
+{
+  return realNanos() * 6 / 10;
+}
+
+} // namespace host
+
+#define F_CPU_ACTUAL 600000000
+#define ARM_DWT_CYCCNT (host::cycles())
+#define SCB_AIRCR (host::scbAircr)
+
+inline uint32_t micros() { return host::nowMicros(); }
+inline uint32_t millis() { return host::nowMicros() / 1000; }
+inline void delay(uint32_t) {}
+inline void pinMode(uint8_t, uint8_t) {}
+inline void digitalWrite(uint8_t, uint8_t) {}
+extern "C" inline uint32_t set_arm_clock(uint32_t frequency) { return frequency; }
+
+class Print;
+
+class Printable
+{
+public:
+  virtual ~Printable() {}
+  virtual size_t printTo(Print &p) const = 0;
+};
+
+class Print
+{
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t) { return 1; }
+  virtual size_t write(const uint8_t *buffer, size_t size)
+  {
+    for (size_t i = 0; i < size; i++)
+      write(buffer[i]);
+    return size;
+  }
+  size_t write(const char *buffer, size_t size) { return write((const uint8_t *)buffer, size); }
+
+  size_t print(const char *s) { return write(s, strlen(s)); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(const Printable &p) { return p.printTo(*this); }
+  size_t print(double v, int digits = 2) { return printf("%.*f", digits, v); }
+  template <typename T, typename std::enable_if<std::is_integral<T>::value, int>::type = 0>
+  size_t print(T v, int base = DEC)
+  {
+    if (base == HEX)
+      return printf("%llX", (unsigned long long)v);
+    return std::is_signed<T>::value ? printf("%lld", (long long)v) : printf("%llu", (unsigned long long)v);
+  }
+
+  size_t println() { return print("\r\n"); }
+  template <typename... Args>
+  size_t println(Args... args)
+  {
+    size_t n = print(args...);
+    return n + println();
+  }
+
+  size_t printf(const char *format, ...)
+  {
+    char buffer[256];
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    return write(buffer, min(n, (int)sizeof(buffer) - 1));
+  }
+};
+
+class Stream : public Print
+{
+public:
+  virtual int available() { return 0; }
+  virtual int read() { return -1; }
+
+  size_t readBytesUntil(char terminator, char *buffer, size_t length)
+  {
+    size_t n = 0;
+    while (n < length)
+    {
+      int c = read();
+      if (c < 0 || c == terminator)
+        break;
+      buffer[n++] = c;
+    }
+    return n;
+  }
+};
+
+class HardwareSerial : public Stream
+{
+public:
+  void begin(long) {}
+  operator bool() { return true; }
+};
+
+inline HardwareSerial Serial;
+
+class IPAddress : public Printable
+{
+public:
+  IPAddress() : address(0) {}
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : address(a | b << 8 | c << 16 | (uint32_t)d << 24) {}
+  IPAddress(uint32_t a) : address(a) {}
+  IPAddress(const uint8_t *a) { memcpy(&address, a, 4); }
+
+  operator uint32_t() const { return address; }
+  uint8_t operator[](int i) const { return address >> (8 * i); }
+  bool operator==(const IPAddress &other) const { return address == other.address; }
+  bool operator!=(const IPAddress &other) const { return address != other.address; }
+
+  size_t printTo(Print &p) const override
+  {
+    return p.printf("%u.%u.%u.%u", (*this)[0], (*this)[1], (*this)[2], (*this)[3]);
+  }
+
+private:
+  uint32_t address;
+};
+
+#endif // HOST_ARDUINO_H
@@ -0,0 +1,11 @@
+#ifndef HOST_INTERVALTIMER_H
+#define HOST_INTERVALTIMER_H
+
+class IntervalTimer
+{
+public:
+  bool begin(void (*)(), unsigned long) { return true; }
+  void end() {}
+};
+
+#endif // HOST_INTERVALTIMER_H
@@ -0,0 +1,78 @@
+// Host OctoWS2811: pixels are kept in the drawing buffer as RGB(W) bytes and
+// show() copies them to the display buffer, no DMA and never busy.
+
+#ifndef HOST_OCTOWS2811_H
+#define HOST_OCTOWS2811_H
+
+#include <Arduino.h>
+
+#define WS2811_RGB 0
+#define WS2811_RBG 1
+#define WS2811_GRB 2
+#define WS2811_GBR 3
+#define WS2811_BRG 4
+#define WS2811_BGR 5
+#define WS2811_RGBW 6
+#define WS2811_RBGW 7
+#define WS2811_GRBW 8
+#define WS2811_GBRW 9
+#define WS2811_BRGW 10
+#define WS2811_BGRW 11
+#define WS2811_800kHz 0x00
+#define WS2811_400kHz 0x10
+#define WS2813_800kHz 0x20
+
+class OctoWS2811
+{
+public:
+  OctoWS2811(uint32_t numPerStrip, void *frameBuf, void *drawBuf, uint8_t config = WS2811_GRB, uint8_t numPins = 8, const uint8_t * = NULL)
+    : stripLen(numPerStrip), frameBuffer(frameBuf), drawBuffer(drawBuf), numPins(numPins),
+      pixelBytes((config & 0x0F) >= WS2811_RGBW ? 4 : 3), shows(0) {}
+
+  void begin() {}
+
+  void show()
+  {
+    memcpy(frameBuffer, drawBuffer, numPixels() * pixelBytes);
+    shows++;
+  }
+
+  int busy() { return 0; }
+
+  void setPixel(uint32_t num, uint8_t red, uint8_t green, uint8_t blue)
+  {
+    uint8_t *p = (uint8_t *)drawBuffer + num * pixelBytes;
+    p[0] = red;
+    p[1] = green;
+    p[2] = blue;
+  }
+
+  void setPixel(uint32_t num, uint8_t red, uint8_t green, uint8_t blue, uint8_t white)
+  {
+    setPixel(num, red, green, blue);
+    ((uint8_t *)drawBuffer)[num * pixelBytes + 3] = white;
+  }
+
+  int getPixel(uint32_t num)
+  {
+    const uint8_t *p = (const uint8_t *)drawBuffer + num * pixelBytes;
+    uint32_t color = p[0] << 16 | p[1] << 8 | p[2];
+    if (pixelBytes == 4)
+      color |= (uint32_t)p[3] << 24;
+    return color;
+  }
+
+  int numPixels() { return stripLen * numPins; }
+
+  uint32_t getShows() { return shows; }
+
+private:
+  uint32_t stripLen;
+  void *frameBuffer;
+  void *drawBuffer;
+  uint8_t numPins;
+  uint8_t pixelBytes;
+  uint32_t shows;
+};
+
+#endif // HOST_OCTOWS2811_H
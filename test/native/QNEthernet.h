@@ -0,0 +1,182 @@
+// Host QNEthernet: UDP sockets exchange datagrams over an in-process network.
+// A socket is bound to the address Ethernet was last started with, so
+// several simulated nodes can run side by side. The web server never has a
+// client.
+
+#ifndef HOST_QNETHERNET_H
+#define HOST_QNETHERNET_H
+
+#include <Arduino.h>
+
+#include <deque>
+#include <vector>
+
+namespace qindesign {
+namespace network {
+
+class EthernetClass
+{
+public:
+  bool begin(const uint8_t *, IPAddress ip)
+  {
+    local = ip;
+    return true;
+  }
+
+  bool begin(IPAddress ip, IPAddress, IPAddress)
+  {
+    local = ip;
+    return true;
+  }
+
+  IPAddress localIP() { return local; }
+
+private:
+  IPAddress local;
+};
+
+inline EthernetClass Ethernet;
+
+struct host_datagram_s {
+  IPAddress from;
+  uint16_t fromPort;
+  std::vector<uint8_t> data;
+};
+
+class EthernetUDP;
+
+inline std::vector<EthernetUDP *> &hostSockets()
+{
+  static std::vector<EthernetUDP *> sockets;
+  return sockets;
+}
+
+class EthernetUDP : public Stream
+{
+public:
+  EthernetUDP() : localPort(0), position(0) {}
+  EthernetUDP(const EthernetUDP &) = delete;
+  ~EthernetUDP() { stop(); }
+
+  bool begin(uint16_t port)
+  {
+    stop();
+    localIP = Ethernet.localIP();
+    localPort = port;
+    hostSockets().push_back(this);
+    return true;
+  }
+
+  void stop()
+  {
+    std::vector<EthernetUDP *> &sockets = hostSockets();
+    sockets.erase(std::remove(sockets.begin(), sockets.end(), this), sockets.end());
+    queue.clear();
+  }
+
+  int parsePacket()
+  {
+    if (queue.empty())
+      return 0;
+    current = std::move(queue.front());
+    queue.pop_front();
+    position = 0;
+    return current.data.size();
+  }
+
+  IPAddress remoteIP() { return current.from; }
+  uint16_t remotePort() { return current.fromPort; }
+
+  int available() override { return current.data.size() - position; }
+
+  int read() override { return position < current.data.size() ? current.data[position++] : -1; }
+
+  int read(uint8_t *buffer, size_t length)
+  {
+    size_t n = min(length, current.data.size() - position);
+    memcpy(buffer, current.data.data() + position, n);
+    position += n;
+    return n;
+  }
+
+  int beginPacket(IPAddress ip, uint16_t port)
+  {
+    outIP = ip;
+    outPort = port;
+    out.clear();
+    return 1;
+  }
+
+  size_t write(uint8_t b) override
+  {
+    out.push_back(b);
+    return 1;
+  }
+
+  size_t write(const uint8_t *buffer, size_t size) override
+  {
+    out.insert(out.end(), buffer, buffer + size);
+    return size;
+  }
+
+  int endPacket()
+  {
+    deliver(outIP, outPort, out.data(), out.size());
+    return 1;
+  }
+
+  bool send(IPAddress ip, uint16_t port, const uint8_t *data, size_t length)
+  {
+    deliver(ip, port, data, length);
+    return true;
+  }
+
+  // Datagrams waiting to be read
+  size_t pending() { return queue.size(); }
+
+private:
+  // Unicast to the socket bound to `ip`, or to every other node for an x.x.x.255 broadcast
+  void deliver(IPAddress ip, uint16_t port, const uint8_t *data, size_t length)
+  {
+    bool broadcast = ip[3] == 255;
+    for (EthernetUDP *socket : hostSockets())
+    {
+      if (socket->localPort != port || socket->localIP == localIP)
+        continue;
+      if (broadcast || socket->localIP == ip)
+        socket->queue.push_back({ localIP, localPort, std::vector<uint8_t>(data, data + length) });
+    }
+  }
+
+  IPAddress localIP;
+  uint16_t localPort;
+  std::deque<host_datagram_s> queue;
+  host_datagram_s current;
+  size_t position;
+
+  IPAddress outIP;
+  uint16_t outPort;
+  std::vector<uint8_t> out;
+};
+
+class EthernetClient : public Stream
+{
+public:
+  operator bool() { return false; }
+  bool connected() { return false; }
+  void flush() {}
+  void stop() {}
+};
+
+class EthernetServer
+{
+public:
+  EthernetServer(uint16_t) {}
+  void begin() {}
+  EthernetClient available() { return EthernetClient(); }
+};
+
+} // namespace network
+} // namespace qindesign
+
+#endif // HOST_QNETHERNET_H
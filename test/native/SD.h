@@ -0,0 +1,116 @@
+// Host SD card: files live in memory. There is no card until a test sets
+// host::sdCard, so the firmware runs as it does with the slot empty.
+
+#ifndef HOST_SD_H
+#define HOST_SD_H
+
+#include <Arduino.h>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#define FILE_READ 0
+#define FILE_WRITE 1
+#define BUILTIN_SDCARD 254
+
+namespace host {
+
+inline bool sdCard = false;
+inline uint32_t sdReads = 0; // Calls to File::read(buffer, length), each one an SD access on the Teensy
+
+inline std::map<std::string, std::shared_ptr<std::vector<uint8_t>>> &sdFiles()
+{
+  static std::map<std::string, std::shared_ptr<std::vector<uint8_t>>> files;
+  return files;
+}
+
+} // namespace host
+
+class File : public Stream
+{
+public:
+  File() : position_(0) {}
+  File(std::shared_ptr<std::vector<uint8_t>> data, uint64_t position) : data(data), position_(position) {}
+
+  operator bool() { return data != nullptr; }
+  void close() { data = nullptr; }
+
+  size_t write(const uint8_t *buffer, size_t size) override
+  {
+    if (!data)
+      return 0;
+    if (position_ + size > data->size())
+      data->resize(position_ + size);
+    memcpy(data->data() + position_, buffer, size);
+    position_ += size;
+    return size;
+  }
+
+  size_t write(uint8_t b) override { return write(&b, 1); }
+
+  int read(void *buffer, size_t length)
+  {
+    if (!data)
+      return 0;
+    host::sdReads++;
+    size_t n = min(length, (size_t)(data->size() - position_));
+    memcpy(buffer, data->data() + position_, n);
+    position_ += n;
+    return n;
+  }
+
+  int read() override
+  {
+    uint8_t b;
+    return read(&b, 1) == 1 ? b : -1;
+  }
+
+  int available() override { return data ? data->size() - position_ : 0; }
+
+  bool seek(uint64_t position)
+  {
+    if (!data || position > data->size())
+      return false;
+    position_ = position;
+    return true;
+  }
+
+  uint64_t position() { return position_; }
+  uint64_t size() { return data ? data->size() : 0; }
+
+private:
+  std::shared_ptr<std::vector<uint8_t>> data;
+  uint64_t position_;
+};
+
+class SDClass
+{
+public:
+  bool begin(uint8_t) { return host::sdCard; }
+
+  // FILE_WRITE creates the file and starts at its end, like the Teensy library
+  File open(const char *path, uint8_t mode = FILE_READ)
+  {
+    if (!host::sdCard)
+      return File();
+    std::shared_ptr<std::vector<uint8_t>> &data = host::sdFiles()[path];
+    if (!data)
+    {
+      if (mode != FILE_WRITE)
+      {
+        host::sdFiles().erase(path);
+        return File();
+      }
+      data = std::make_shared<std::vector<uint8_t>>();
+    }
+    return File(data, mode == FILE_WRITE ? data->size() : 0);
+  }
+
+  bool remove(const char *path) { return host::sdCard && host::sdFiles().erase(path) > 0; }
+};
+
+inline SDClass SD;
+
+#endif // HOST_SD_H
@@ -0,0 +1,90 @@
+// Helpers for the native tests: sockets for simulated senders, Art-Net
+// packet builders matching tools/artnet_loadgen.cpp and benchmark timing.
+
+#ifndef HOST_HOST_H
+#define HOST_HOST_H
+
+#include <Arduino.h>
+#include <QNEthernet.h>
+
+#include <functional>
+#include <vector>
+
+#include "artnet.h"
+
+namespace host {
+
+// Bind `socket` as a node at `ip` without changing the address the firmware runs as
+inline void bindSocket(qindesign::network::EthernetUDP &socket, IPAddress ip, uint16_t port)
+{
+  using qindesign::network::Ethernet;
+  IPAddress local = Ethernet.localIP();
+  Ethernet.begin(NULL, ip);
+  socket.begin(port);
+  Ethernet.begin(NULL, local);
+}
+
+inline std::vector<uint8_t> artHeader(uint16_t opcode, size_t size)
+{
+  std::vector<uint8_t> packet(size, 0);
+  memcpy(packet.data(), ART_NET_ID, ART_NET_ID_SIZE);
+  packet[8] = opcode & 0xFF;
+  packet[9] = opcode >> 8;
+  packet[11] = ART_NET_VERSION;
+  return packet;
+}
+
+// A moving ramp, so every frame changes every channel
+inline std::vector<uint8_t> artDmx(uint16_t universe, uint8_t sequence, uint16_t length, uint32_t frame = 0)
+{
+  std::vector<uint8_t> packet = artHeader(ART_DMX, ART_DMX_START + length);
+  packet[12] = sequence;
+  packet[14] = universe & 0xFF;
+  packet[15] = universe >> 8;
+  packet[16] = length >> 8;
+  packet[17] = length & 0xFF;
+  for (uint16_t i = 0; i < length; i++)
+    packet[ART_DMX_START + i] = (uint8_t)(i + frame);
+  return packet;
+}
+
+inline std::vector<uint8_t> artSync()
+{
+  return artHeader(ART_SYNC, 14);
+}
+
+// Nearest-rank percentile of `samples`, sorted in place
+inline double percentile(std::vector<double> &samples, double percent)
+{
+  if (samples.empty())
+    return 0;
+  std::sort(samples.begin(), samples.end());
+  size_t rank = (size_t)(percent / 100 * (samples.size() - 1) + 0.5);
+  return samples[rank];
+}
+
+// Time every one of `runs` once per round, alternating between them so drift
+// on the host hits all alike, and keep each one's fastest round in ns. The
+// minimum drops rounds that were preempted or found a cold cache.
+// `prepare(i)`, if given, runs untimed before run i, e.g. to queue its packets.
+inline std::vector<double> fastest(int rounds, const std::vector<std::function<void()>> &runs,
+                                   const std::function<void(size_t)> &prepare = nullptr)
+{
+  std::vector<double> best(runs.size(), 1e30);
+  for (int r = 0; r < rounds; r++)
+  {
+    for (size_t i = 0; i < runs.size(); i++)
+    {
+      if (prepare)
+        prepare(i);
+      uint64_t start = realNanos();
+      runs[i]();
+      best[i] = std::min(best[i], (double)(realNanos() - start));
+    }
+  }
+  return best;
+}
+
+} // namespace host
+
+#endif // HOST_HOST_H
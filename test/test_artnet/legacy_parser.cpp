@@ -0,0 +1,43 @@
+#include "legacy_parser.h"
+
+uint16_t LegacyParser::read()
+{
+  packetSize = Udp.parsePacket();
+
+  remoteIP = Udp.remoteIP();
+  if (packetSize <= MAX_BUFFER_ARTNET && packetSize > 0)
+  {
+    Udp.read(artnetPacket, MAX_BUFFER_ARTNET);
+    for (byte i = 0; i < 8; i++)
+    {
+      if (artnetPacket[i] != ART_NET_ID[i])
+        return 0;
+    }
+    opcode = artnetPacket[8] | artnetPacket[9] << 8;
+    if (opcode == ART_DMX)
+    {
+      sequence = artnetPacket[12];
+      incomingUniverse = artnetPacket[14] | artnetPacket[15] << 8;
+      dmxDataLength = artnetPacket[17] | artnetPacket[16] << 8;
+
+      if (artDmxCallback) (*artDmxCallback)(incomingUniverse, dmxDataLength, sequence, artnetPacket + ART_DMX_START, remoteIP);
+      return ART_DMX;
+    }
+    if (opcode == ART_POLL)
+      return ART_POLL;
+    if (opcode == ART_SYNC)
+    {
+      if (artSyncCallback) (*artSyncCallback)(remoteIP);
+      return ART_SYNC;
+    }
+  }
+  return 0;
+}
+
+uint16_t UdpOnlyParser::read()
+{
+  int packetSize = Udp.parsePacket();
+  if (packetSize > 0)
+    Udp.read(artnetPacket, packetSize);
+  return 0;
+}
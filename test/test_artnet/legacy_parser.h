@@ -0,0 +1,41 @@
+// Baselines for the parser benchmark, in their own file so that, like
+// Artnet::read(), they can't be inlined into the benchmark loop.
+
+#ifndef LEGACY_PARSER_H
+#define LEGACY_PARSER_H
+
+#include <Arduino.h>
+#include <QNEthernet.h>
+
+#include "artnet.h"
+
+// The parser before the single-pass rewrite: byte loop over the ID, no
+// version or length checks, if-chain dispatch
+class LegacyParser
+{
+public:
+  uint16_t read();
+
+  qindesign::network::EthernetUDP Udp;
+  uint8_t artnetPacket[MAX_BUFFER_ARTNET] __attribute__((aligned(8)));
+  int packetSize;
+  uint16_t opcode;
+  uint8_t sequence;
+  uint16_t incomingUniverse;
+  uint16_t dmxDataLength;
+  IPAddress remoteIP;
+  void (*artDmxCallback)(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t *data, IPAddress remoteIP) = NULL;
+  void (*artSyncCallback)(IPAddress remoteIP) = NULL;
+};
+
+// Only receives, the cost of the host UDP stand-in both parsers pay
+class UdpOnlyParser
+{
+public:
+  uint16_t read();
+
+  qindesign::network::EthernetUDP Udp;
+  uint8_t artnetPacket[MAX_BUFFER_ARTNET] __attribute__((aligned(8)));
+};
+
+#endif // LEGACY_PARSER_H
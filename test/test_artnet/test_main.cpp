@@ -0,0 +1,275 @@
+// Art-Net header parsing on the host build: malformed packets must never
+// reach the ArtDmx callback with data beyond what was received, and the
+// single-pass parser is benchmarked against the byte-loop/if-chain parser it
+// replaced (legacy_parser.cpp).
+
+#include <unity.h>
+
+#include <host.h>
+
+#include <random>
+
+#include "artnet.h"
+#include "legacy_parser.h"
+
+using namespace qindesign::network;
+
+#define CONSOLE_IP IPAddress(10, 0, 0, 1)
+#define NODE_IP IPAddress(10, 0, 0, 2)
+#define LEGACY_IP IPAddress(10, 0, 0, 3)
+#define UDP_ONLY_IP IPAddress(10, 0, 0, 4)
+
+static Artnet node;
+static EthernetUDP console;
+
+static int dmxCalls;
+static uint16_t dmxLength;
+static int syncCalls;
+static size_t sentSize;
+
+static void onDmx(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t *data, IPAddress remoteIP)
+{
+  dmxCalls++;
+  dmxLength = length;
+  // The data handed over has to lie inside the received packet
+  TEST_ASSERT_TRUE(data == node.getDmxFrame());
+  TEST_ASSERT_LESS_OR_EQUAL(sentSize, (size_t)ART_DMX_START + length);
+}
+
+static void onSync(IPAddress remoteIP)
+{
+  syncCalls++;
+}
+
+static uint16_t receive(const std::vector<uint8_t> &packet)
+{
+  sentSize = packet.size();
+  console.send(NODE_IP, ART_NET_PORT, packet.data(), packet.size());
+  return node.read();
+}
+
+void setUp()
+{
+  dmxCalls = 0;
+  syncCalls = 0;
+}
+
+void tearDown()
+{
+}
+
+void test_valid_dmx()
+{
+  TEST_ASSERT_EQUAL_UINT16(ART_DMX, receive(host::artDmx(3, 7, 512)));
+  TEST_ASSERT_EQUAL(1, dmxCalls);
+  TEST_ASSERT_EQUAL_UINT16(512, dmxLength);
+  TEST_ASSERT_EQUAL_UINT16(3, node.getUniverse());
+  TEST_ASSERT_EQUAL(7, node.getSequence());
+}
+
+void test_runt_packets()
+{
+  std::vector<uint8_t> packet = host::artDmx(0, 1, 2);
+  for (size_t size = 0; size < ART_DMX_START; size++)
+  {
+    TEST_ASSERT_EQUAL_UINT16(0, receive(std::vector<uint8_t>(packet.begin(), packet.begin() + size)));
+  }
+  TEST_ASSERT_EQUAL(0, dmxCalls);
+}
+
+void test_length_beyond_packet()
+{
+  // Claims 512 channels, carries 100
+  std::vector<uint8_t> packet = host::artDmx(0, 1, 512);
+  packet.resize(ART_DMX_START + 100);
+  TEST_ASSERT_EQUAL_UINT16(0, receive(packet));
+
+  // One byte short
+  packet = host::artDmx(0, 1, 100);
+  packet.pop_back();
+  TEST_ASSERT_EQUAL_UINT16(0, receive(packet));
+  TEST_ASSERT_EQUAL(0, dmxCalls);
+}
+
+void test_length_over_512()
+{
+  std::vector<uint8_t> packet = host::artDmx(0, 1, 514);
+  TEST_ASSERT_EQUAL_UINT16(0, receive(packet));
+  TEST_ASSERT_EQUAL(0, dmxCalls);
+}
+
+void test_oversized_packet()
+{
+  std::vector<uint8_t> packet = host::artDmx(0, 1, 512);
+  packet.resize(MAX_BUFFER_ARTNET + 1);
+  TEST_ASSERT_EQUAL_UINT16(0, receive(packet));
+  TEST_ASSERT_EQUAL(0, dmxCalls);
+}
+
+void test_bad_id_and_version()
+{
+  std::vector<uint8_t> packet = host::artDmx(0, 1, 512);
+  packet[6] = 'T';
+  TEST_ASSERT_EQUAL_UINT16(0, receive(packet));
+
+  packet = host::artDmx(0, 1, 512);
+  packet[7] = ' '; // ID must be NUL terminated
+  TEST_ASSERT_EQUAL_UINT16(0, receive(packet));
+
+  packet = host::artDmx(0, 1, 512);
+  packet[11] = ART_NET_VERSION - 1;
+  TEST_ASSERT_EQUAL_UINT16(0, receive(packet));
+
+  // Newer revisions are accepted
+  packet[10] = 1;
+  TEST_ASSERT_EQUAL_UINT16(ART_DMX, receive(packet));
+  TEST_ASSERT_EQUAL(1, dmxCalls);
+}
+
+void test_opcode_dispatch()
+{
+  TEST_ASSERT_EQUAL_UINT16(ART_SYNC, receive(host::artSync()));
+  TEST_ASSERT_EQUAL(1, syncCalls);
+  TEST_ASSERT_EQUAL_UINT16(ART_POLL, receive(host::artHeader(ART_POLL, 14)));
+
+  // Unknown opcodes, including ones sharing a high byte with a handled one
+  const uint16_t unknown[] = { 0x0000, 0x2100, 0x5001, 0x50FF, 0x5100, 0x9700, 0xF800, 0xFFFF };
+  for (uint16_t opcode : unknown)
+  {
+    TEST_ASSERT_EQUAL_UINT16(0, receive(host::artHeader(opcode, 530)));
+  }
+  TEST_ASSERT_EQUAL(0, dmxCalls);
+  TEST_ASSERT_EQUAL(1, syncCalls);
+}
+
+// Random truncation and corruption of the header of a valid ArtDmx. Whatever
+// gets through must agree with the reference checks below.
+void test_fuzz_header()
+{
+  std::mt19937 rng(2024);
+  const std::vector<uint8_t> valid = host::artDmx(1, 1, 512);
+  int accepted = 0;
+  for (int i = 0; i < 100000; i++)
+  {
+    std::vector<uint8_t> packet = valid;
+    int flips = rng() % 4;
+    for (int f = 0; f < flips; f++)
+      packet[rng() % ART_DMX_START] = rng();
+    if (rng() % 2)
+      packet.resize(rng() % (valid.size() + 1));
+
+    int before = dmxCalls;
+    uint16_t result = receive(packet);
+
+    bool wellFormed = packet.size() >= ART_DMX_START && memcmp(packet.data(), ART_NET_ID, ART_NET_ID_SIZE) == 0 &&
+                      (packet[10] << 8 | packet[11]) >= ART_NET_VERSION && packet[8] == 0x00 && packet[9] == 0x50;
+    uint16_t length = wellFormed ? packet[16] << 8 | packet[17] : 0;
+    wellFormed = wellFormed && length <= ART_DMX_MAX_LENGTH && ART_DMX_START + length <= (int)packet.size();
+
+    if (wellFormed)
+    {
+      TEST_ASSERT_EQUAL_UINT16(ART_DMX, result);
+      TEST_ASSERT_EQUAL(before + 1, dmxCalls);
+      accepted++;
+    }
+    else
+    {
+      TEST_ASSERT_TRUE(result != ART_DMX);
+      TEST_ASSERT_EQUAL(before, dmxCalls);
+    }
+  }
+  printf("fuzz: %d of 100000 mutated packets accepted\n", accepted);
+}
+
+static uint32_t checksum;
+
+static void onDmxBench(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t *data, IPAddress remoteIP)
+{
+  checksum += sequence + universe + length + data[0];
+}
+
+// Mixed traffic: mostly full ArtDmx, some ArtSync, ArtPoll and foreign UDP
+static std::vector<std::vector<uint8_t>> benchTraffic()
+{
+  std::vector<std::vector<uint8_t>> traffic;
+  for (int i = 0; i < 64; i++)
+  {
+    if (i % 16 == 15)
+      traffic.push_back(std::vector<uint8_t>(200, 0x55));
+    else if (i % 16 == 10)
+      traffic.push_back(host::artSync());
+    else
+      traffic.push_back(host::artDmx(i % 10, i % 255 + 1, 512, i));
+  }
+  return traffic;
+}
+
+template <typename Parser>
+static std::function<void()> readAll(Parser &parser, size_t packets)
+{
+  return [&parser, packets]() {
+    for (size_t i = 0; i < packets; i++)
+      parser.read();
+  };
+}
+
+void test_benchmark_parser()
+{
+  const std::vector<std::vector<uint8_t>> traffic = benchTraffic();
+  const int rounds = 5000;
+
+  LegacyParser *legacy = new LegacyParser;
+  UdpOnlyParser *udpOnly = new UdpOnlyParser;
+  host::bindSocket(legacy->Udp, LEGACY_IP, ART_NET_PORT);
+  host::bindSocket(udpOnly->Udp, UDP_ONLY_IP, ART_NET_PORT);
+  legacy->artDmxCallback = onDmxBench;
+  node.setArtDmxCallback(onDmxBench);
+  node.setArtSyncCallback(NULL);
+
+  const IPAddress targets[] = { UDP_ONLY_IP, LEGACY_IP, NODE_IP };
+  std::vector<double> ns = host::fastest(rounds, {
+    readAll(*udpOnly, traffic.size()),
+    readAll(*legacy, traffic.size()),
+    readAll(node, traffic.size()),
+  }, [&](size_t i) {
+    for (const std::vector<uint8_t> &packet : traffic)
+      console.send(targets[i], ART_NET_PORT, packet.data(), packet.size());
+  });
+  for (double &n : ns)
+    n /= traffic.size();
+  double udpNs = ns[0], legacyNs = ns[1], parserNs = ns[2];
+
+  printf("parser: %zu packets, fastest of %d rounds, net of %.1f ns/packet for the host UDP stand-in\n",
+         traffic.size(), rounds, udpNs);
+  printf("  byte loop + if chain   %.1f ns/packet\n", legacyNs - udpNs);
+  printf("  single pass + table    %.1f ns/packet, with version and length checks\n", parserNs - udpNs);
+
+  node.setArtDmxCallback(onDmx);
+  node.setArtSyncCallback(onSync);
+  delete legacy;
+  delete udpOnly;
+  TEST_ASSERT_TRUE(checksum != 0);
+  TEST_ASSERT_LESS_THAN(legacyNs, parserNs);
+}
+
+int main(int argc, char **argv)
+{
+  uint8_t mac[6] = { 0 };
+  uint8_t ip[4] = { 10, 0, 0, 2 };
+  node.begin(mac, ip);
+  node.setArtDmxCallback(onDmx);
+  node.setArtSyncCallback(onSync);
+  host::bindSocket(console, CONSOLE_IP, ART_NET_PORT);
+
+  UNITY_BEGIN();
+  RUN_TEST(test_valid_dmx);
+  RUN_TEST(test_runt_packets);
+  RUN_TEST(test_length_beyond_packet);
+  RUN_TEST(test_length_over_512);
+  RUN_TEST(test_oversized_packet);
+  RUN_TEST(test_bad_id_and_version);
+  RUN_TEST(test_opcode_dispatch);
+  RUN_TEST(test_fuzz_header);
+  RUN_TEST(test_benchmark_parser);
+  return UNITY_END();
+}
@@ -0,0 +1,231 @@
+// Art-Net forwarding on the host build: routed universes are merged HTP,
+// sent once per frame with a single ArtSync per downstream node, and sent
+// early when a universe repeats before the flush. The benchmark feeds frames
+// through Artnet::read() into forward() and flush() and compares against the
+// same traffic on a node without routes.
+
+#include <unity.h>
+
+#include <host.h>
+
+#include "artnet.h"
+
+using namespace qindesign::network;
+
+#define CONSOLE_IP IPAddress(10, 0, 0, 1)
+#define NODE_IP IPAddress(10, 0, 0, 2)
+#define PLAIN_IP IPAddress(10, 0, 0, 3)
+#define TARGET_A IPAddress(10, 0, 0, 20)
+#define TARGET_B IPAddress(10, 0, 0, 21)
+
+static EthernetUDP console;
+static EthernetUDP targetA;
+static EthernetUDP targetB;
+static Artnet *node;
+static Artnet *receiving; // Node whose read() is running, for the callback
+
+static void onDmx(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t *data, IPAddress remoteIP)
+{
+  receiving->forward(universe, length, data);
+}
+
+static Artnet *startNode(IPAddress ip)
+{
+  uint8_t mac[6] = { 0 };
+  uint8_t bytes[4] = { ip[0], ip[1], ip[2], ip[3] };
+  Artnet *artnet = new Artnet;
+  artnet->begin(mac, bytes);
+  artnet->setArtDmxCallback(onDmx);
+  return artnet;
+}
+
+static void receive(Artnet *artnet, IPAddress ip, const std::vector<uint8_t> &packet)
+{
+  console.send(ip, ART_NET_PORT, packet.data(), packet.size());
+  receiving = artnet;
+  artnet->read();
+}
+
+static std::vector<std::vector<uint8_t>> drain(EthernetUDP &socket)
+{
+  std::vector<std::vector<uint8_t>> packets;
+  int size;
+  while ((size = socket.parsePacket()) > 0)
+  {
+    std::vector<uint8_t> packet(size);
+    socket.read(packet.data(), size);
+    packets.push_back(packet);
+  }
+  return packets;
+}
+
+static uint16_t opcodeOf(const std::vector<uint8_t> &packet)
+{
+  return packet[8] | packet[9] << 8;
+}
+
+static uint16_t universeOf(const std::vector<uint8_t> &packet)
+{
+  return packet[14] | packet[15] << 8;
+}
+
+static uint16_t lengthOf(const std::vector<uint8_t> &packet)
+{
+  return packet[16] << 8 | packet[17];
+}
+
+void setUp()
+{
+  host::bindSocket(console, CONSOLE_IP, ART_NET_PORT);
+  host::bindSocket(targetA, TARGET_A, ART_NET_PORT);
+  host::bindSocket(targetB, TARGET_B, ART_NET_PORT);
+  node = startNode(NODE_IP);
+}
+
+void tearDown()
+{
+  delete node;
+  console.stop();
+  targetA.stop();
+  targetB.stop();
+}
+
+void test_routes_merge_highest_takes_precedence()
+{
+  TEST_ASSERT_TRUE(node->addRoute(1, TARGET_A, 100));
+  TEST_ASSERT_TRUE(node->addRoute(2, TARGET_A, 100));
+
+  std::vector<uint8_t> low = host::artDmx(1, 1, 6);
+  std::vector<uint8_t> high = host::artDmx(2, 1, 4);
+  const uint8_t lowData[6] = { 10, 200, 30, 40, 50, 60 };
+  const uint8_t highData[4] = { 100, 20, 30, 255 };
+  memcpy(low.data() + ART_DMX_START, lowData, sizeof(lowData));
+  memcpy(high.data() + ART_DMX_START, highData, sizeof(highData));
+  receive(node, NODE_IP, low);
+  receive(node, NODE_IP, high);
+  receive(node, NODE_IP, host::artDmx(3, 1, 6)); // Not routed
+
+  TEST_ASSERT_EQUAL(1, node->flush());
+  std::vector<std::vector<uint8_t>> packets = drain(targetA);
+  TEST_ASSERT_EQUAL(2, packets.size());
+  TEST_ASSERT_EQUAL_UINT16(ART_DMX, opcodeOf(packets[0]));
+  TEST_ASSERT_EQUAL_UINT16(100, universeOf(packets[0]));
+  TEST_ASSERT_EQUAL_UINT16(6, lengthOf(packets[0]));
+  const uint8_t merged[6] = { 100, 200, 30, 255, 50, 60 };
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(merged, packets[0].data() + ART_DMX_START, 6);
+  TEST_ASSERT_EQUAL_UINT16(ART_SYNC, opcodeOf(packets[1]));
+  TEST_ASSERT_EQUAL(0, drain(targetB).size());
+  TEST_ASSERT_EQUAL_UINT32(1, node->getForwarded());
+}
+
+void test_one_sync_per_target()
+{
+  TEST_ASSERT_TRUE(node->addRoute(1, TARGET_A, 100));
+  TEST_ASSERT_TRUE(node->addRoute(2, TARGET_A, 101));
+  TEST_ASSERT_TRUE(node->addRoute(3, TARGET_B, 200));
+  for (uint16_t u = 1; u <= 3; u++)
+    receive(node, NODE_IP, host::artDmx(u, 1, 512));
+
+  TEST_ASSERT_EQUAL(3, node->flush());
+  std::vector<std::vector<uint8_t>> a = drain(targetA);
+  std::vector<std::vector<uint8_t>> b = drain(targetB);
+  TEST_ASSERT_EQUAL(3, a.size());
+  TEST_ASSERT_EQUAL_UINT16(100, universeOf(a[0]));
+  TEST_ASSERT_EQUAL_UINT16(101, universeOf(a[1]));
+  TEST_ASSERT_EQUAL_UINT16(ART_SYNC, opcodeOf(a[2]));
+  TEST_ASSERT_EQUAL(2, b.size());
+  TEST_ASSERT_EQUAL_UINT16(200, universeOf(b[0]));
+  TEST_ASSERT_EQUAL_UINT16(ART_SYNC, opcodeOf(b[1]));
+
+  // Nothing new, nothing sent
+  TEST_ASSERT_EQUAL(0, node->flush());
+  TEST_ASSERT_EQUAL(0, targetA.pending() + targetB.pending());
+}
+
+void test_repeated_universe_is_sent_early()
+{
+  TEST_ASSERT_TRUE(node->addRoute(1, TARGET_A, 100));
+  receive(node, NODE_IP, host::artDmx(1, 1, 8, 0));
+  TEST_ASSERT_EQUAL(0, targetA.pending());
+
+  // The next frame starts without an ArtSync, the first one goes out unmerged
+  receive(node, NODE_IP, host::artDmx(1, 2, 8, 50));
+  std::vector<std::vector<uint8_t>> early = drain(targetA);
+  TEST_ASSERT_EQUAL(1, early.size());
+  TEST_ASSERT_EQUAL_UINT8(1, early[0][12]);
+  TEST_ASSERT_EQUAL_UINT8(0, early[0][ART_DMX_START]);
+
+  TEST_ASSERT_EQUAL(1, node->flush());
+  std::vector<std::vector<uint8_t>> flushed = drain(targetA);
+  TEST_ASSERT_EQUAL(2, flushed.size());
+  TEST_ASSERT_EQUAL_UINT8(2, flushed[0][12]);
+  TEST_ASSERT_EQUAL_UINT8(50, flushed[0][ART_DMX_START]);
+  TEST_ASSERT_EQUAL_UINT16(ART_SYNC, opcodeOf(flushed[1]));
+}
+
+void test_route_limits()
+{
+  for (int i = 0; i < ART_MAX_FORWARD_OUTPUTS; i++)
+    TEST_ASSERT_TRUE(node->addRoute(i, TARGET_A, 100 + i));
+  // Out of outputs, but another route into an existing one still fits
+  TEST_ASSERT_FALSE(node->addRoute(ART_MAX_FORWARD_OUTPUTS, TARGET_A, 100 + ART_MAX_FORWARD_OUTPUTS));
+  for (int i = ART_MAX_FORWARD_OUTPUTS; i < ART_MAX_ROUTES; i++)
+    TEST_ASSERT_TRUE(node->addRoute(i, TARGET_A, 100));
+  TEST_ASSERT_FALSE(node->addRoute(ART_MAX_ROUTES, TARGET_A, 100));
+  TEST_ASSERT_EQUAL(ART_MAX_ROUTES, node->getRouteCount());
+}
+
+// One frame of `universes` universes into `artnet`, returns the ns spent in
+// flush()
+static uint64_t runFrame(Artnet *artnet, IPAddress ip, const std::vector<std::vector<uint8_t>> &frame)
+{
+  for (const std::vector<uint8_t> &packet : frame)
+    receive(artnet, ip, packet);
+  uint64_t start = host::realNanos();
+  artnet->flush();
+  return host::realNanos() - start;
+}
+
+void test_benchmark_forwarding()
+{
+  // 16 universes in, 8 of them forwarded: pairs merged into 4 outputs on 2 nodes
+  const int universes = 16;
+  const int rounds = 4000;
+  for (int u = 0; u < 8; u++)
+    TEST_ASSERT_TRUE(node->addRoute(u, u < 4 ? TARGET_A : TARGET_B, 100 + u / 2));
+  Artnet *plain = startNode(PLAIN_IP);
+
+  std::vector<std::vector<uint8_t>> frame;
+  for (int u = 0; u < universes; u++)
+    frame.push_back(host::artDmx(u, 1, 512, u));
+
+  std::vector<double> flushUs;
+  flushUs.reserve(rounds);
+  std::vector<double> ns = host::fastest(rounds, {
+    [&]() { runFrame(plain, PLAIN_IP, frame); },
+    [&]() { flushUs.push_back(runFrame(node, NODE_IP, frame) / 1e3); },
+  }, [](size_t) {
+    drain(targetA);
+    drain(targetB);
+  });
+  uint32_t forwarded = node->getForwarded();
+
+  printf("forward: %d universes in, 8 routes into 4 outputs on 2 nodes, fastest of %d frames\n", universes, rounds);
+  printf("  throughput       %.0f frames/s, %.0f forwarded universes/s\n", 1e9 / ns[1], 4e9 / ns[1]);
+  printf("  cost per frame   %.2f us over a node without routes\n", (ns[1] - ns[0]) / 1e3);
+  printf("  flush            p50 %.2f us, p99 %.2f us\n", host::percentile(flushUs, 50), host::percentile(flushUs, 99));
+
+  delete plain;
+  TEST_ASSERT_EQUAL_UINT32(rounds * 4, forwarded);
+}
+
+int main(int argc, char **argv)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_routes_merge_highest_takes_precedence);
+  RUN_TEST(test_one_sync_per_target);
+  RUN_TEST(test_repeated_universe_is_sent_early);
+  RUN_TEST(test_route_limits);
+  RUN_TEST(test_benchmark_forwarding);
+  return UNITY_END();
+}
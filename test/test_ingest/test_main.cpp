@@ -0,0 +1,208 @@
+// End-to-end ingest benchmark on the host build: ArtDmx from a simulated
+// console through Artnet::read(), onDmxFrame and presentation, reporting
+// throughput, packet-to-pixel latency and drop rate the way the node does
+// under tools/artnet_loadgen.cpp.
+
+#include <unity.h>
+
+#include <host.h>
+
+#include <OctoWS2811.h>
+
+#include "artnet.h"
+#include "config.h"
+#include "netstats.h"
+
+using namespace qindesign::network;
+
+#define CONSOLE_IP IPAddress(192, 168, 1, 10)
+#define DOWNSTREAM_IP IPAddress(192, 168, 1, 20)
+#define UNIVERSES 10
+#define LENGTH 510
+
+void initializeLEDs();
+void initializeArtNet();
+void loop();
+extern OctoWS2811 leds;
+
+static EthernetUDP console;
+static uint8_t sequence[UNIVERSES];
+
+void setUp()
+{
+  host::bindSocket(console, CONSOLE_IP, ART_NET_PORT);
+  memset(sequence, 0, sizeof(sequence));
+  netStats.reset();
+}
+
+void tearDown()
+{
+  console.stop();
+}
+
+static void sendDmx(uint16_t universe, uint8_t seq, uint32_t frame)
+{
+  std::vector<uint8_t> packet = host::artDmx(universe, seq, LENGTH, frame);
+  console.send(staticIP, ART_NET_PORT, packet.data(), packet.size());
+}
+
+static uint8_t nextSequence(int universe)
+{
+  sequence[universe] = sequence[universe] == 255 ? 1 : sequence[universe] + 1;
+  return sequence[universe];
+}
+
+// One loop() per packet sent, plus one for the frame tick
+static void run(int packets)
+{
+  for (int i = 0; i <= packets; i++)
+    loop();
+}
+
+void test_loss_and_reorder_are_counted_apart()
+{
+  uint32_t lost = 0, swapped = 0;
+  uint8_t held = 0;
+  for (uint32_t frame = 0; frame < 200; frame++)
+  {
+    int sent = 0;
+    for (int u = 0; u < UNIVERSES; u++)
+    {
+      uint8_t seq = nextSequence(u);
+      if (u == 3 && frame % 10 == 1)
+      {
+        lost++;
+        continue;
+      }
+      if (u == 6 && frame % 10 == 5)
+      {
+        // Sent one frame late, after the next packet of the universe
+        held = seq;
+        swapped++;
+        continue;
+      }
+      sendDmx(u, seq, frame);
+      sent++;
+      if (u == 6 && held != 0)
+      {
+        sendDmx(u, held, frame - 1);
+        held = 0;
+        sent++;
+      }
+    }
+    run(sent);
+  }
+
+  TEST_ASSERT_EQUAL_UINT32(lost, netStats.getDropped());
+  TEST_ASSERT_EQUAL_UINT32(swapped, netStats.getReordered());
+}
+
+void test_benchmark_ingest()
+{
+  const uint32_t frames = 2000;
+  uint32_t packets = 0;
+  std::vector<double> latency; // us from send to the show() that displays the packet
+  std::vector<uint64_t> waiting;
+  uint64_t start = host::realNanos();
+  for (uint32_t frame = 0; frame < frames; frame++)
+  {
+    for (int u = 0; u < UNIVERSES; u++)
+    {
+      waiting.push_back(host::realNanos());
+      sendDmx(u, nextSequence(u), frame);
+    }
+    packets += UNIVERSES;
+
+    for (int i = 0; i <= UNIVERSES; i++)
+    {
+      uint32_t shows = leds.getShows();
+      loop();
+      if (leds.getShows() == shows)
+        continue;
+      uint64_t shown = host::realNanos();
+      for (uint64_t sent : waiting)
+        latency.push_back((shown - sent) / 1e3);
+      waiting.clear();
+    }
+  }
+  double seconds = (host::realNanos() - start) / 1e9;
+
+  printf("ingest: %u universes x %u channels, %u frames\n", UNIVERSES, LENGTH, frames);
+  printf("  throughput       %.0f packets/s (%.0f frames/s)\n", packets / seconds, frames / seconds);
+  printf("  packet-to-pixel  p50 %.1f us, p99 %.1f us\n", host::percentile(latency, 50), host::percentile(latency, 99));
+  printf("  node statistics  p50 <= %u us, p99 <= %u us\n", netStats.getLatencyPercentile(50), netStats.getLatencyPercentile(99));
+  printf("  drop rate        %.3f %%\n", 100.0 * netStats.getDropped() / packets);
+
+  TEST_ASSERT_EQUAL_UINT32(packets, netStats.getPackets());
+  TEST_ASSERT_EQUAL_UINT32(0, netStats.getDropped());
+  TEST_ASSERT_EQUAL(packets, latency.size());
+  TEST_ASSERT_LESS_OR_EQUAL(netStats.getFrames(), frames);
+}
+
+// A frame tick that lands mid-burst must not forward the half of the frame
+// that has arrived with an ArtSync of its own
+void test_tick_mid_frame_does_not_tear()
+{
+  EthernetUDP downstream;
+  host::bindSocket(downstream, DOWNSTREAM_IP, ART_NET_PORT);
+  TEST_ASSERT_TRUE(artnet.addRoute(0, DOWNSTREAM_IP, 100));
+  TEST_ASSERT_TRUE(artnet.addRoute(UNIVERSES - 1, DOWNSTREAM_IP, 100 + UNIVERSES - 1));
+  host::manualMicros = host::nowMicros();
+  host::manualClock = true;
+
+  // The first frame makes the universes live, the second one is the first
+  // whose end the node can tell
+  for (uint32_t frame = 0; frame < 2; frame++)
+  {
+    for (int u = 0; u < UNIVERSES; u++)
+      sendDmx(u, nextSequence(u), frame);
+    run(UNIVERSES);
+  }
+  while (downstream.parsePacket() > 0)
+    ;
+
+  for (uint32_t frame = 2; frame < 20; frame++)
+  {
+    for (int u = 0; u < UNIVERSES; u++)
+    {
+      sendDmx(u, nextSequence(u), frame);
+      loop();
+      if (u == UNIVERSES / 2)
+      {
+        // Well past the update interval, the next loop() is a tick
+        host::manualMicros += 50000;
+        loop();
+        TEST_ASSERT_EQUAL(0, downstream.pending());
+      }
+    }
+
+    // Both forwarded universes of the frame and one ArtSync
+    std::vector<uint8_t> packets[3];
+    for (std::vector<uint8_t> &packet : packets)
+    {
+      int size = downstream.parsePacket();
+      TEST_ASSERT_GREATER_THAN(0, size);
+      packet.resize(size);
+      downstream.read(packet.data(), size);
+    }
+    TEST_ASSERT_EQUAL(0, downstream.parsePacket());
+    TEST_ASSERT_EQUAL_UINT8(frame, packets[0][ART_DMX_START]);
+    TEST_ASSERT_EQUAL_UINT8(frame, packets[1][ART_DMX_START]);
+    TEST_ASSERT_EQUAL_UINT16(ART_SYNC, packets[2][8] | packets[2][9] << 8);
+  }
+
+  host::manualClock = false;
+  downstream.stop();
+}
+
+int main(int argc, char **argv)
+{
+  initializeLEDs();
+  initializeArtNet();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_tick_mid_frame_does_not_tear);
+  RUN_TEST(test_loss_and_reorder_are_counted_apart);
+  RUN_TEST(test_benchmark_ingest);
+  return UNITY_END();
+}
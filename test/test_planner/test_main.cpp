@@ -0,0 +1,92 @@
+// Frame budget model on the host build: known WS281x timings in, the plan the
+// web interface shows out, and measured cycle averages kept to cycle precision
+// until the per-frame sum.
+
+#include <unity.h>
+
+#include <host.h>
+
+#include "config.h"
+#include "planner.h"
+
+#define CYCLES_PER_US (F_CPU_ACTUAL / 1000000)
+#define STRIPS 5     // NUM_STRIPS
+#define UNIVERSES 10 // maxUniverses
+
+extern int num_leds_pr_out;
+extern uint8_t pixelChannels;
+
+void setUp()
+{
+  memset(&ingestTiming, 0, sizeof(ingestTiming));
+  memset(&showTiming, 0, sizeof(showTiming));
+  updateSpeed = 60;
+}
+
+void tearDown() {}
+
+void test_output_bound_rgb_strip()
+{
+  // 340 RGB LEDs at 800 kHz: 24 bits of 1.25 us each
+  frame_plan_s plan = planFrame({ 340, 5, 3, 10 }, 0, 0, 60);
+  TEST_ASSERT_EQUAL_UINT32(10200, plan.transmitUs);
+  TEST_ASSERT_EQUAL_UINT32(300, plan.latchUs);
+  TEST_ASSERT_EQUAL_UINT32(10500, plan.outputUs);
+  TEST_ASSERT_EQUAL_UINT32(WS2811_DMA_SETUP_US, plan.setupUs);
+  TEST_ASSERT_EQUAL_UINT32(WS2811_DMA_SETUP_US, plan.cpuUs);
+  TEST_ASSERT_EQUAL_UINT16(95, plan.maxFps);
+  // 16666 us per frame at 60 Hz, 10500 of it used
+  TEST_ASSERT_EQUAL_INT16(36, plan.headroom);
+
+  plan = planFrame({ 340, 5, 3, 10 }, 0, 0, 120);
+  TEST_ASSERT_EQUAL_INT16(-26, plan.headroom);
+
+  // RGBW adds a byte per LED
+  plan = planFrame({ 340, 5, 4, 10 }, 0, 0, 60);
+  TEST_ASSERT_EQUAL_UINT32(13600, plan.transmitUs);
+  TEST_ASSERT_EQUAL_UINT16(71, plan.maxFps);
+}
+
+void test_cpu_bound_when_ingest_is_slow()
+{
+  // 100 short universes at 120 us each outrun a 50-LED strip
+  frame_plan_s plan = planFrame({ 50, 5, 3, 100 }, 120 * CYCLES_PER_US, 200 * CYCLES_PER_US, 60);
+  TEST_ASSERT_EQUAL_UINT32(1800, plan.outputUs);
+  TEST_ASSERT_EQUAL_UINT32(12200, plan.cpuUs);
+  TEST_ASSERT_EQUAL_UINT16(81, plan.maxFps);
+  TEST_ASSERT_EQUAL_INT16(26, plan.headroom);
+}
+
+void test_ingest_average_is_not_truncated()
+{
+  setFrameConfig(340, STRIPS, 3, UNIVERSES);
+  // 3.9 us per universe: truncated first, 10 universes would come to 30 us
+  recordTiming(ingestTiming, 2340);
+  recordTiming(showTiming, 25 * CYCLES_PER_US);
+  frame_plan_s plan = currentFramePlan();
+  TEST_ASSERT_EQUAL_UINT32(3, plan.ingestUs);
+  TEST_ASSERT_EQUAL_UINT32(25, plan.setupUs);
+  TEST_ASSERT_EQUAL_UINT32(64, plan.cpuUs);
+}
+
+void test_current_config()
+{
+  setFrameConfig(num_leds_pr_out, STRIPS, pixelChannels, UNIVERSES);
+  frame_plan_s plan = currentFramePlan();
+  uint32_t transmitUs = (uint32_t)num_leds_pr_out * pixelChannels * 8 * WS2811_BIT_NS / 1000;
+  TEST_ASSERT_EQUAL_UINT32(transmitUs, plan.transmitUs);
+  TEST_ASSERT_EQUAL_UINT32(transmitUs + WS2811_LATCH_US, plan.outputUs);
+  TEST_ASSERT_EQUAL_UINT16(1000000 / plan.outputUs, plan.maxFps);
+  // Two universes of RGB per output run at the 60 Hz default with room to spare
+  TEST_ASSERT_GREATER_THAN(30, plan.headroom);
+}
+
+int main(int argc, char **argv)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_output_bound_rgb_strip);
+  RUN_TEST(test_cpu_bound_when_ingest_is_slow);
+  RUN_TEST(test_ingest_average_is_not_truncated);
+  RUN_TEST(test_current_config);
+  return UNITY_END();
+}
@@ -0,0 +1,192 @@
+// Power limiter on the host build: an over-budget frame is shown scaled to
+// the budget while the pixel buffer keeps the source, so universes that are
+// not rewritten do not fade frame after frame. The benchmark prices the
+// limiter against presenting the same frames without it.
+
+#include <unity.h>
+
+#include <host.h>
+
+#include <OctoWS2811.h>
+
+#include "config.h"
+
+#define STRIPS 5
+#define UNIVERSES 10 // Two per strip
+#define LENGTH 510   // 170 RGB pixels
+#define PIXELS_PER_STRIP 340
+#define MA_PER_CHANNEL 20 // LED_MA_PER_CHANNEL
+#define MA_IDLE 1         // LED_MA_IDLE
+
+void initializeLEDs();
+bool writeUniverse(uint16_t universe, uint16_t length, uint8_t *data);
+void presentFrame();
+void updateLEDs();
+extern bool outputDirty;
+extern int drawingMemory[];
+extern int displayMemory[];
+extern OctoWS2811 leds;
+
+static uint8_t white[LENGTH];
+static uint8_t ramp[UNIVERSES][LENGTH];
+
+// Current the shown frame draws by the limiter's own estimate, mA
+static uint32_t stripEstimate(int strip)
+{
+  const uint8_t *pixels = (const uint8_t *)displayMemory + strip * PIXELS_PER_STRIP * 3;
+  uint32_t level = 0;
+  for (int i = 0; i < PIXELS_PER_STRIP * 3; i++)
+    level += pixels[i];
+  return level * MA_PER_CHANNEL / 255 + PIXELS_PER_STRIP * MA_IDLE;
+}
+
+static uint32_t totalEstimate()
+{
+  uint32_t total = 0;
+  for (int strip = 0; strip < STRIPS; strip++)
+    total += stripEstimate(strip);
+  return total;
+}
+
+static void writeAll(uint8_t (*frame)[LENGTH])
+{
+  for (int u = 0; u < UNIVERSES; u++)
+    writeUniverse(u, LENGTH, frame ? frame[u] : white);
+}
+
+static std::vector<uint8_t> drawing()
+{
+  const uint8_t *bytes = (const uint8_t *)drawingMemory;
+  return std::vector<uint8_t>(bytes, bytes + STRIPS * PIXELS_PER_STRIP * 3);
+}
+
+static std::vector<uint8_t> display()
+{
+  const uint8_t *bytes = (const uint8_t *)displayMemory;
+  return std::vector<uint8_t>(bytes, bytes + STRIPS * PIXELS_PER_STRIP * 3);
+}
+
+void setUp()
+{
+  outputBudget = 0;
+  powerBudget = 0;
+}
+
+void tearDown()
+{
+  outputBudget = 0;
+  powerBudget = 0;
+}
+
+void test_full_white_is_shown_within_budget()
+{
+  outputBudget = 2000;
+  powerBudget = 5000;
+  writeAll(NULL);
+  std::vector<uint8_t> source = drawing();
+  presentFrame();
+
+  for (int strip = 0; strip < STRIPS; strip++)
+    TEST_ASSERT_LESS_OR_EQUAL(outputBudget, stripEstimate(strip));
+  TEST_ASSERT_LESS_OR_EQUAL(powerBudget, totalEstimate());
+  // Scaled, not blacked out
+  TEST_ASSERT_GREATER_THAN(0, ((const uint8_t *)displayMemory)[0]);
+  TEST_ASSERT_TRUE(drawing() == source);
+}
+
+void test_unchanged_universes_do_not_drift()
+{
+  outputBudget = 2000;
+  powerBudget = 5000;
+  writeAll(NULL);
+  presentFrame();
+  std::vector<uint8_t> first = display();
+  std::vector<uint8_t> source = drawing();
+
+  // Only universe 0 keeps arriving, with the same data
+  for (int frame = 0; frame < 10; frame++)
+  {
+    writeUniverse(0, LENGTH, white);
+    presentFrame();
+    TEST_ASSERT_TRUE(display() == first);
+    TEST_ASSERT_TRUE(drawing() == source);
+  }
+}
+
+void test_within_budget_is_untouched()
+{
+  outputBudget = 100000;
+  powerBudget = 500000;
+  writeAll(ramp);
+  presentFrame();
+  TEST_ASSERT_TRUE(display() == drawing());
+}
+
+void test_benchmark_limiter()
+{
+  const int frames = 20;
+  const int rounds = 200;
+
+  // A frame as the node presents it, with the budgets in force
+  auto present = [](uint32_t output, uint32_t power, uint8_t (*frame)[LENGTH]) {
+    return [=]() {
+      outputBudget = output;
+      powerBudget = power;
+      for (int f = 0; f < frames; f++)
+      {
+        writeAll(frame);
+        presentFrame();
+      }
+    };
+  };
+  // The same frames without the limiter
+  auto baseline = [](uint8_t (*frame)[LENGTH]) {
+    return [=]() {
+      for (int f = 0; f < frames; f++)
+      {
+        writeAll(frame);
+        updateLEDs();
+        outputDirty = false;
+      }
+    };
+  };
+
+  std::vector<double> ns = host::fastest(rounds, {
+    baseline(ramp),
+    present(0, 0, ramp),
+    present(100000, 500000, ramp),
+    baseline(NULL),
+    present(2000, 5000, NULL),
+  });
+  for (double &n : ns)
+    n /= frames * 1000.0;
+
+  printf("power limiter: %d strips x %d pixels, us per frame (fastest of %d rounds)\n", STRIPS, PIXELS_PER_STRIP, rounds);
+  printf("  no limiter       %.2f us\n", ns[0]);
+  printf("  budgets off      %.2f us (%+.2f)\n", ns[1], ns[1] - ns[0]);
+  printf("  in budget        %.2f us (%+.2f)\n", ns[2], ns[2] - ns[0]);
+  printf("  no limiter       %.2f us, full white\n", ns[3]);
+  printf("  over budget      %.2f us (%+.2f), full white\n", ns[4], ns[4] - ns[3]);
+
+  // Off and in budget only add the level sums; scaling the whole frame
+  // costs less than a quarter of writing it
+  TEST_ASSERT_LESS_THAN(ns[0] * 0.05 + 0.2, ns[1] - ns[0]);
+  TEST_ASSERT_LESS_THAN(ns[0] * 0.05 + 0.2, ns[2] - ns[0]);
+  TEST_ASSERT_LESS_THAN(ns[3] * 0.25, ns[4] - ns[3]);
+}
+
+int main(int argc, char **argv)
+{
+  initializeLEDs();
+  memset(white, 255, sizeof(white));
+  for (int u = 0; u < UNIVERSES; u++)
+    for (int i = 0; i < LENGTH; i++)
+      ramp[u][i] = (i + u * 7) & 0x3F;
+
+  UNITY_BEGIN();
+  RUN_TEST(test_full_white_is_shown_within_budget);
+  RUN_TEST(test_unchanged_universes_do_not_drift);
+  RUN_TEST(test_within_budget_is_untouched);
+  RUN_TEST(test_benchmark_limiter);
+  return UNITY_END();
+}
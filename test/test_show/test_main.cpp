@@ -0,0 +1,328 @@
+// Show recording and playback on the host build, against the in-memory SD
+// card: what the player hands back at any time has to match what was
+// captured at that time, across delta records, keyframes forced by an
+// overrun, a thinned index and records that wrap the player's ring buffer.
+
+#include <unity.h>
+
+#include <host.h>
+
+#include <SD.h>
+
+#include "show.h"
+
+#define UNIVERSES 3
+
+static const uint16_t universeNumbers[UNIVERSES] = { 0, 1, 7 };
+static const uint16_t universeLengths[UNIVERSES] = { 512, 510, 100 };
+
+struct snapshot_s {
+  uint32_t time;
+  std::vector<std::vector<uint8_t>> data;
+};
+
+static std::vector<std::vector<uint8_t>> live;
+static std::vector<std::vector<uint8_t>> played;
+static uint32_t playedFrames;
+static uint32_t seed;
+
+static uint32_t random(uint32_t low, uint32_t high)
+{
+  seed = seed * 1664525 + 1013904223;
+  return low + (seed >> 8) % (high - low);
+}
+
+static void onFrame(uint16_t universe, uint16_t length, uint8_t *data)
+{
+  for (int u = 0; u < UNIVERSES; u++)
+  {
+    if (universeNumbers[u] == universe)
+      played[u].assign(data, data + length);
+  }
+  playedFrames++;
+}
+
+static uint32_t now()
+{
+  return millis();
+}
+
+static void advance(uint32_t ms)
+{
+  host::manualMicros += ms * 1000ULL;
+}
+
+// Mostly a few channels moving, sometimes a whole new look
+static void change(int u)
+{
+  std::vector<uint8_t> &data = live[u];
+  if (random(0, 20) == 0)
+  {
+    for (uint8_t &b : data)
+      b = random(0, 256);
+    return;
+  }
+  int count = random(1, 12);
+  for (int i = 0; i < count; i++)
+    data[random(0, data.size())] = random(0, 256);
+}
+
+static void captureAll()
+{
+  for (int u = 0; u < UNIVERSES; u++)
+    showRecorder.capture(universeNumbers[u], live[u].size(), live[u].data());
+}
+
+// Records of the file in order, with their file offsets
+static std::vector<std::pair<uint32_t, show_record_s>> records()
+{
+  const std::vector<uint8_t> &file = *host::sdFiles()[SHOW_FILE];
+  show_header_s header;
+  memcpy(&header, file.data(), sizeof(header));
+  uint32_t end = header.indexOffset ? header.indexOffset : file.size();
+
+  std::vector<std::pair<uint32_t, show_record_s>> list;
+  for (uint32_t pos = sizeof(header); pos + sizeof(show_record_s) <= end;)
+  {
+    show_record_s record;
+    memcpy(&record, file.data() + pos, sizeof(record));
+    list.push_back({ pos, record });
+    pos += sizeof(record) + record.length;
+  }
+  return list;
+}
+
+static show_header_s header()
+{
+  show_header_s header;
+  memcpy(&header, host::sdFiles()[SHOW_FILE]->data(), sizeof(header));
+  return header;
+}
+
+// Run the player up to `time` ms into the show
+static void playTo(uint32_t start, uint32_t time)
+{
+  host::manualMicros = (start + time) * 1000ULL;
+  for (int i = 0; i < 64 && showPlayer.isPlaying(); i++)
+    showPlayer.service();
+}
+
+void setUp()
+{
+  host::sdCard = true;
+  host::sdFiles().clear();
+  host::manualClock = true;
+  host::manualMicros = 1000000;
+  seed = 1;
+  live.clear();
+  played.clear();
+  for (int u = 0; u < UNIVERSES; u++)
+  {
+    live.push_back(std::vector<uint8_t>(universeLengths[u], 0));
+    played.push_back(std::vector<uint8_t>());
+  }
+  playedFrames = 0;
+  showPlayer.setFrameCallback(onFrame);
+}
+
+void tearDown()
+{
+  showRecorder.end();
+  showPlayer.end();
+  host::manualClock = false;
+  host::sdCard = false;
+}
+
+void test_round_trip_matches_every_frame()
+{
+  TEST_ASSERT_TRUE(showRecorder.begin(SHOW_FILE));
+  uint32_t start = now();
+  std::vector<snapshot_s> snapshots;
+  for (int frame = 0; frame < 800; frame++)
+  {
+    advance(25);
+    for (int u = 0; u < UNIVERSES; u++)
+      change(u);
+    captureAll();
+    showRecorder.service();
+    snapshots.push_back({ now() - start, live });
+  }
+  advance(25);
+  showRecorder.end();
+  TEST_ASSERT_EQUAL_UINT32(0, showRecorder.getOverruns());
+
+  int keys = 0, deltas = 0, syncs = 0;
+  for (auto &entry : records())
+  {
+    keys += entry.second.type == SHOW_REC_KEY;
+    deltas += entry.second.type == SHOW_REC_DELTA;
+    syncs += entry.second.type == SHOW_REC_SYNC;
+  }
+  TEST_ASSERT_GREATER_THAN(keys, deltas);
+  TEST_ASSERT_EQUAL(21, syncs); // 20 s plus the one at the start
+  // 800 frames of 1122 bytes would not fit the player's ring buffer once
+  TEST_ASSERT_GREATER_THAN(8 * SHOW_BUFFER_SIZE, host::sdFiles()[SHOW_FILE]->size());
+
+  TEST_ASSERT_TRUE(showPlayer.begin(SHOW_FILE, false));
+  uint32_t playStart = now();
+  for (const snapshot_s &snapshot : snapshots)
+  {
+    playTo(playStart, snapshot.time);
+    for (int u = 0; u < UNIVERSES; u++)
+      TEST_ASSERT_TRUE(played[u] == snapshot.data[u]);
+  }
+  playTo(playStart, header().duration);
+  TEST_ASSERT_FALSE(showPlayer.isPlaying());
+}
+
+void test_overrun_forces_a_keyframe()
+{
+  TEST_ASSERT_TRUE(showRecorder.begin(SHOW_FILE));
+  uint32_t start = now();
+  advance(10);
+
+  // Whole-universe changes with the SD card never serviced fill both halves
+  uint32_t overrunAt = now() - start;
+  for (int i = 0; i < 20; i++)
+  {
+    for (int u = 0; u < UNIVERSES; u++)
+      for (uint8_t &b : live[u])
+        b = random(0, 256);
+    captureAll();
+  }
+  TEST_ASSERT_GREATER_THAN(0, showRecorder.getOverruns());
+
+  showRecorder.service();
+  advance(10);
+  live[0][3] ^= 0xFF; // A one-channel change, which would otherwise be a delta
+  captureAll();
+  showRecorder.service();
+  uint32_t recoveredAt = now() - start;
+  advance(10);
+  showRecorder.end();
+
+  // Universe 0's first record after the overrun is whole
+  for (auto &entry : records())
+  {
+    if (entry.second.time == recoveredAt && entry.second.universe == universeNumbers[0])
+    {
+      TEST_ASSERT_EQUAL(SHOW_REC_KEY, entry.second.type);
+      break;
+    }
+  }
+
+  TEST_ASSERT_TRUE(showPlayer.begin(SHOW_FILE, false));
+  uint32_t playStart = now();
+  playTo(playStart, overrunAt);
+  playTo(playStart, recoveredAt);
+  for (int u = 0; u < UNIVERSES; u++)
+    TEST_ASSERT_TRUE(played[u] == live[u]);
+}
+
+void test_index_thinning_and_seek()
+{
+  TEST_ASSERT_TRUE(showRecorder.begin(SHOW_FILE));
+  uint32_t start = now();
+  std::vector<snapshot_s> snapshots;
+  // Past two thinnings of the index: over 2 x SHOW_INDEX_SIZE keyframes
+  for (int frame = 0; frame < 2 * 1100; frame++)
+  {
+    advance(500);
+    change(0);
+    showRecorder.capture(universeNumbers[0], live[0].size(), live[0].data());
+    showRecorder.service();
+    snapshots.push_back({ now() - start, live });
+  }
+  showRecorder.end();
+
+  show_header_s head = header();
+  TEST_ASSERT_LESS_OR_EQUAL(SHOW_INDEX_SIZE, head.indexCount);
+  TEST_ASSERT_GREATER_THAN(SHOW_INDEX_SIZE / 2, head.indexCount);
+
+  // Every entry points at a SYNC record of its time, evenly spread
+  const std::vector<uint8_t> &file = *host::sdFiles()[SHOW_FILE];
+  std::vector<show_index_s> index(head.indexCount);
+  memcpy(index.data(), file.data() + head.indexOffset, head.indexCount * sizeof(show_index_s));
+  for (uint16_t i = 0; i < head.indexCount; i++)
+  {
+    show_record_s record;
+    memcpy(&record, file.data() + index[i].offset, sizeof(record));
+    TEST_ASSERT_EQUAL(SHOW_REC_SYNC, record.type);
+    TEST_ASSERT_EQUAL_UINT32(index[i].time, record.time);
+    if (i > 1)
+      TEST_ASSERT_EQUAL_UINT32(index[i].time - index[i - 1].time, index[i - 1].time - index[i - 2].time);
+  }
+  TEST_ASSERT_EQUAL_UINT32(4 * SHOW_KEYFRAME_INTERVAL, index[1].time - index[0].time);
+
+  // Seeking lands on a keyframe and plays forward to the exact state
+  TEST_ASSERT_TRUE(showPlayer.begin(SHOW_FILE, false));
+  const snapshot_s &target = snapshots[1500];
+  uint32_t seekTime = target.time - 2500;
+  showPlayer.seek(seekTime);
+  uint32_t playStart = now() - seekTime;
+  uint32_t reads = host::sdReads;
+  playTo(playStart, target.time);
+  TEST_ASSERT_TRUE(played[0] == target.data[0]);
+  TEST_ASSERT_LESS_OR_EQUAL(4, host::sdReads - reads);
+}
+
+void test_static_tail_plays_to_the_end()
+{
+  TEST_ASSERT_TRUE(showRecorder.begin(SHOW_FILE));
+  live[0][0] = 200;
+  showRecorder.capture(universeNumbers[0], live[0].size(), live[0].data());
+  for (int i = 0; i < 50; i++)
+  {
+    advance(100);
+    showRecorder.service();
+  }
+  showRecorder.end();
+  TEST_ASSERT_EQUAL_UINT32(5000, header().duration);
+
+  TEST_ASSERT_TRUE(showPlayer.begin(SHOW_FILE, true));
+  uint32_t playStart = now();
+  playTo(playStart, 0);
+  TEST_ASSERT_EQUAL_UINT32(1, playedFrames);
+
+  // The last record is long past, but the recording is not
+  uint32_t reads = host::sdReads;
+  for (uint32_t t = 100; t < 5000; t += 100)
+    playTo(playStart, t);
+  TEST_ASSERT_EQUAL_UINT32(1, playedFrames);
+  TEST_ASSERT_EQUAL_UINT32(reads, host::sdReads);
+
+  playTo(playStart, 5000);
+  playTo(playStart, 5001);
+  TEST_ASSERT_EQUAL_UINT32(2, playedFrames);
+}
+
+void test_empty_show_does_not_spin_on_the_card()
+{
+  TEST_ASSERT_TRUE(showRecorder.begin(SHOW_FILE));
+  advance(2000);
+  showRecorder.end();
+  TEST_ASSERT_EQUAL(1, records().size());
+
+  TEST_ASSERT_TRUE(showPlayer.begin(SHOW_FILE, true));
+  uint32_t playStart = now();
+  uint32_t reads = host::sdReads;
+  for (int i = 0; i < 1000; i++)
+    showPlayer.service();
+  playTo(playStart, 1999);
+  TEST_ASSERT_EQUAL_UINT32(reads, host::sdReads);
+
+  playTo(playStart, 2000);
+  TEST_ASSERT_TRUE(showPlayer.isPlaying());
+  TEST_ASSERT_EQUAL_UINT32(reads + 1, host::sdReads);
+}
+
+int main(int argc, char **argv)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_round_trip_matches_every_frame);
+  RUN_TEST(test_overrun_forces_a_keyframe);
+  RUN_TEST(test_index_thinning_and_seek);
+  RUN_TEST(test_static_tail_plays_to_the_end);
+  RUN_TEST(test_empty_show_does_not_spin_on_the_card);
+  return UNITY_END();
+}
@@ -0,0 +1,148 @@
+// Several nodes on the simulated network, each with its own clock offset and
+// drift, running the time sync exchange. Every node is serviced in turn with
+// a random gap and in a random order, so packets wait a variable time before
+// they are stamped the way they do behind LED output on the Teensy. Reports
+// the true skew between the nodes' shared clocks and what the master measures.
+
+#include <unity.h>
+
+#include <host.h>
+
+#include "timesync.h"
+
+using namespace qindesign::network;
+
+#define NODES 6
+#define BROADCAST IPAddress(10, 1, 0, 255)
+#define SECONDS 60
+#define SETTLE_SECONDS 20
+
+struct sim_node_s {
+  int64_t offset; // us
+  int32_t drift;  // ppm
+};
+
+// The master first, then slaves with crystals a few tens of ppm apart
+static const sim_node_s simNodes[NODES] = {
+  { 0, 0 },
+  { 431017, 25 },
+  { -250300, -18 },
+  { 1200450, 40 },
+  { -977, -35 },
+  { 64000, 5 },
+};
+
+static TimeSync nodes[NODES];
+static uint32_t seed = 12345;
+
+static uint32_t random(uint32_t low, uint32_t high)
+{
+  seed = seed * 1664525 + 1013904223;
+  return low + (seed >> 8) % (high - low);
+}
+
+// Switch the host clock to node `i`
+static void runAs(int i)
+{
+  host::clockOffset = simNodes[i].offset + (int64_t)host::manualMicros * simNodes[i].drift / 1000000;
+}
+
+// Spread of the nodes' shared clocks at this instant, us
+static uint32_t trueSkew()
+{
+  runAs(0);
+  uint32_t reference = nodes[0].now();
+  int32_t low = 0, high = 0;
+  for (int i = 1; i < NODES; i++)
+  {
+    runAs(i);
+    int32_t error = nodes[i].now() - reference;
+    low = min(low, error);
+    high = max(high, error);
+  }
+  return high - low;
+}
+
+void setUp()
+{
+  host::manualClock = true;
+  host::manualMicros = 100000000;
+  for (int i = 0; i < NODES; i++)
+  {
+    runAs(i);
+    Ethernet.begin(NULL, IPAddress(10, 1, 0, i + 1));
+    nodes[i].begin(BROADCAST, i == 0 ? TIMESYNC_MASTER : TIMESYNC_SLAVE);
+  }
+}
+
+void tearDown()
+{
+  host::manualClock = false;
+  host::clockOffset = 0;
+}
+
+void test_nodes_converge_on_the_master_clock()
+{
+  std::vector<double> skew, measured;
+  uint64_t end = host::manualMicros + SECONDS * 1000000ULL;
+  uint64_t settled = host::manualMicros + SETTLE_SECONDS * 1000000ULL;
+  uint64_t nextSample = settled;
+  while (host::manualMicros < end)
+  {
+    // A fresh order every pass: a fixed one would make every slave's path to
+    // the master consistently longer or shorter than the way back, an
+    // asymmetry no two-way exchange can see
+    int order[NODES];
+    for (int i = 0; i < NODES; i++)
+    {
+      int j = random(0, i + 1);
+      order[i] = order[j];
+      order[j] = i;
+    }
+    for (int i = 0; i < NODES; i++)
+    {
+      host::manualMicros += random(20, 200);
+      runAs(order[i]);
+      nodes[order[i]].service();
+    }
+    if (host::manualMicros >= nextSample)
+    {
+      skew.push_back(trueSkew());
+      runAs(0);
+      measured.push_back(nodes[0].getSkew());
+      nextSample += 100000;
+    }
+  }
+
+  for (int i = 1; i < NODES; i++)
+  {
+    runAs(i);
+    TEST_ASSERT_TRUE(nodes[i].isSynced());
+  }
+  runAs(0);
+  TEST_ASSERT_EQUAL(NODES - 1, nodes[0].getNodeCount());
+  for (int i = 0; i < nodes[0].getNodeCount(); i++)
+    TEST_ASSERT_TRUE(nodes[0].isLive(nodes[0].getNode(i)));
+
+  double trueP50 = host::percentile(skew, 50), trueP99 = host::percentile(skew, 99);
+  double measuredP50 = host::percentile(measured, 50), measuredP99 = host::percentile(measured, 99);
+  printf("timesync: %u nodes, %u s after %u s to settle\n", NODES, SECONDS - SETTLE_SECONDS, SETTLE_SECONDS);
+  printf("  true skew          p50 %.0f us, p99 %.0f us\n", trueP50, trueP99);
+  printf("  measured by master p50 %.0f us, p99 %.0f us\n", measuredP50, measuredP99);
+  for (int i = 1; i < NODES; i++)
+  {
+    runAs(i);
+    printf("  node %u  offset %ld us, delay %lu us, jitter %lu us\n", i,
+           (long)nodes[i].getOffset(), (unsigned long)nodes[i].getDelay(), (unsigned long)nodes[i].getJitter());
+  }
+
+  TEST_ASSERT_LESS_THAN(500, (uint32_t)trueP99);
+  TEST_ASSERT_LESS_THAN(500, (uint32_t)measuredP99);
+}
+
+int main(int argc, char **argv)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_nodes_converge_on_the_master_clock);
+  return UNITY_END();
+}
@@ -0,0 +1,253 @@
+// Art-Net load generator for benchmarking a Light Node from a Linux host.
+//
+// Sends ArtDmx for a range of universes at a fixed frame rate, optionally
+// followed by ArtSync, with ArtPoll at an interval. Jitter, reordering and
+// loss can be injected to see how the node copes. The node reports packet
+// rate, drops, reordering and packet-to-pixel latency on its web page under
+// "Ingest Statistics"; reset them there before each run.
+//
+// The same traffic is replayed against the host build of the firmware by
+// test/test_ingest (pio test -e native -v), which needs no rig.
+//
+// Build: g++ -O2 -std=c++11 -o artnet_loadgen tools/artnet_loadgen.cpp
+// Usage: artnet_loadgen --target 192.168.1.116 --universes 10 --rate 44 --sync
+
+#include <arpa/inet.h>
+#include <getopt.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+#define ART_NET_PORT 6454
+#define ART_NET_VERSION 14
+#define ART_POLL 0x2000
+#define ART_DMX 0x5000
+#define ART_SYNC 0x5200
+#define ART_DMX_START 18
+
+using Clock = std::chrono::steady_clock;
+
+struct options_s {
+  const char *target = "255.255.255.255";
+  int port = ART_NET_PORT;
+  int universes = 10;
+  int start = 0;
+  double rate = 44;
+  int length = 510;
+  int jitter = 0;      // us, random delay before each packet
+  double reorder = 0;  // % of packets sent one frame late
+  double loss = 0;     // % of packets not sent
+  bool sync = false;
+  double poll = 0;     // s between ArtPoll, 0 = off
+  double duration = 10;
+};
+
+static void usage(const char *name)
+{
+  fprintf(stderr,
+          "Usage: %s [options]\n"
+          "  --target IP       destination (default broadcast)\n"
+          "  --port N          UDP port (default 6454)\n"
+          "  --universes N     universes per frame (default 10)\n"
+          "  --start N         first universe (default 0)\n"
+          "  --rate HZ         frames per second (default 44)\n"
+          "  --length N        DMX channels per packet, even, 2..512 (default 510)\n"
+          "  --jitter US       random delay of up to US before each packet\n"
+          "  --reorder PCT     chance of sending a packet one frame late\n"
+          "  --loss PCT        chance of dropping a packet\n"
+          "  --sync            send ArtSync after every frame\n"
+          "  --poll S          send ArtPoll every S seconds\n"
+          "  --duration S      run time (default 10)\n",
+          name);
+}
+
+static void header(std::vector<uint8_t> &packet, uint16_t opcode)
+{
+  memcpy(packet.data(), "Art-Net\0", 8);
+  packet[8] = opcode & 0xFF;
+  packet[9] = opcode >> 8;
+  packet[10] = 0;
+  packet[11] = ART_NET_VERSION;
+}
+
+static std::vector<uint8_t> dmxPacket(uint16_t universe, uint8_t sequence, int length, uint32_t frame)
+{
+  std::vector<uint8_t> packet(ART_DMX_START + length);
+  header(packet, ART_DMX);
+  packet[12] = sequence;
+  packet[13] = 0;
+  packet[14] = universe & 0xFF;
+  packet[15] = universe >> 8;
+  packet[16] = length >> 8;
+  packet[17] = length & 0xFF;
+  // A moving ramp, so every frame changes every channel
+  for (int i = 0; i < length; i++)
+    packet[ART_DMX_START + i] = (uint8_t)(i + frame);
+  return packet;
+}
+
+int main(int argc, char **argv)
+{
+  options_s opt;
+  static const struct option longOptions[] = {
+    { "target", required_argument, nullptr, 't' },
+    { "port", required_argument, nullptr, 'p' },
+    { "universes", required_argument, nullptr, 'u' },
+    { "start", required_argument, nullptr, 's' },
+    { "rate", required_argument, nullptr, 'r' },
+    { "length", required_argument, nullptr, 'l' },
+    { "jitter", required_argument, nullptr, 'j' },
+    { "reorder", required_argument, nullptr, 'o' },
+    { "loss", required_argument, nullptr, 'x' },
+    { "sync", no_argument, nullptr, 'y' },
+    { "poll", required_argument, nullptr, 'q' },
+    { "duration", required_argument, nullptr, 'd' },
+    { "help", no_argument, nullptr, 'h' },
+    { nullptr, 0, nullptr, 0 },
+  };
+
+  int c;
+  while ((c = getopt_long(argc, argv, "", longOptions, nullptr)) != -1)
+  {
+    switch (c)
+    {
+      case 't': opt.target = optarg; break;
+      case 'p': opt.port = atoi(optarg); break;
+      case 'u': opt.universes = atoi(optarg); break;
+      case 's': opt.start = atoi(optarg); break;
+      case 'r': opt.rate = atof(optarg); break;
+      case 'l': opt.length = atoi(optarg); break;
+      case 'j': opt.jitter = atoi(optarg); break;
+      case 'o': opt.reorder = atof(optarg); break;
+      case 'x': opt.loss = atof(optarg); break;
+      case 'y': opt.sync = true; break;
+      case 'q': opt.poll = atof(optarg); break;
+      case 'd': opt.duration = atof(optarg); break;
+      default: usage(argv[0]); return 1;
+    }
+  }
+  if (opt.rate <= 0 || opt.universes <= 0 || opt.length < 2 || opt.length > 512 || opt.length % 2)
+  {
+    usage(argv[0]);
+    return 1;
+  }
+
+  int sock = socket(AF_INET, SOCK_DGRAM, 0);
+  if (sock < 0)
+  {
+    perror("socket");
+    return 1;
+  }
+  int enable = 1;
+  setsockopt(sock, SOL_SOCKET, SO_BROADCAST, &enable, sizeof(enable));
+
+  sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(opt.port);
+  if (inet_pton(AF_INET, opt.target, &addr.sin_addr) != 1)
+  {
+    fprintf(stderr, "Invalid target address: %s\n", opt.target);
+    return 1;
+  }
+
+  std::mt19937 rng(12345);
+  std::uniform_real_distribution<double> chance(0, 100);
+  std::uniform_int_distribution<int> jitter(0, opt.jitter);
+
+  std::vector<uint8_t> syncPacket(14, 0);
+  header(syncPacket, ART_SYNC);
+  std::vector<uint8_t> pollPacket(14, 0);
+  header(pollPacket, ART_POLL);
+
+  const auto period = std::chrono::duration<double>(1.0 / opt.rate);
+  const auto start = Clock::now();
+  const auto end = start + std::chrono::duration<double>(opt.duration);
+  auto nextPoll = start;
+  std::vector<uint8_t> sequence(opt.universes, 0);
+  std::vector<std::vector<uint8_t>> held;
+
+  uint64_t frames = 0, sent = 0, lost = 0, swapped = 0, bytes = 0;
+  double lateMax = 0, lateSum = 0;
+
+  auto send = [&](const std::vector<uint8_t> &packet) {
+    if (sendto(sock, packet.data(), packet.size(), 0, (sockaddr *)&addr, sizeof(addr)) >= 0)
+    {
+      sent++;
+      bytes += packet.size();
+    }
+  };
+
+  for (auto frameTime = start; frameTime < end; frameTime += std::chrono::duration_cast<Clock::duration>(period))
+  {
+    std::this_thread::sleep_until(frameTime);
+    double late = std::chrono::duration<double, std::micro>(Clock::now() - frameTime).count();
+    lateMax = std::max(lateMax, late);
+    lateSum += late;
+
+    // A reordered packet is held back and sent after the next frame's
+    // packet for the same universe
+    std::vector<std::vector<uint8_t>> packets, delayed;
+    for (int u = 0; u < opt.universes; u++)
+    {
+      sequence[u] = sequence[u] == 255 ? 1 : sequence[u] + 1;
+      if (chance(rng) < opt.loss)
+      {
+        lost++;
+        continue;
+      }
+      auto packet = dmxPacket(opt.start + u, sequence[u], opt.length, frames);
+      if (chance(rng) < opt.reorder)
+      {
+        delayed.push_back(packet);
+        swapped++;
+      }
+      else
+      {
+        packets.push_back(packet);
+      }
+    }
+    packets.insert(packets.end(), held.begin(), held.end());
+    held.swap(delayed);
+
+    for (const auto &packet : packets)
+    {
+      if (opt.jitter > 0)
+      {
+        int delay = jitter(rng);
+        if (delay > 0)
+          std::this_thread::sleep_for(std::chrono::microseconds(delay));
+      }
+      send(packet);
+    }
+    if (opt.sync)
+      send(syncPacket);
+
+    if (opt.poll > 0 && Clock::now() >= nextPoll)
+    {
+      send(pollPacket);
+      nextPoll += std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(opt.poll));
+    }
+    frames++;
+  }
+
+  double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+  printf("frames        %llu (%.1f fps)\n", (unsigned long long)frames, frames / elapsed);
+  printf("packets sent  %llu (%.0f /s, %.2f Mbit/s)\n", (unsigned long long)sent, sent / elapsed, bytes * 8 / elapsed / 1e6);
+  printf("dropped       %llu (injected)\n", (unsigned long long)lost);
+  printf("reordered     %llu (injected)\n", (unsigned long long)swapped);
+  printf("frame start   avg %.0f us late, max %.0f us late\n", frames ? lateSum / frames : 0, lateMax);
+
+  close(sock);
+  return 0;
+}